@@ -91,10 +91,6 @@ long_date() {
   TZ=$tz date -d $(full_date $1) '+%A, %d de %B de %Y'
 }
 
-unixtime() {
-  TZ=$tz date -d $(full_date $1) '+%s'
-}
-
 # data da última modificação de arquivo em segundos da era unix
 timestamp() {
   stat -c %Y "$1"
@@ -119,15 +115,31 @@ value_of() {
   sed -nr "/^\.$1/ { s/.+(\d34|\d39)(.+)\1.*/\2/p; q }" $2
 }
 
+# extrai o n-ésimo argumento literal de chamada de função SQL de script arbitrário
+argument_of() {
+  sed -nr "/$1\(/ { s/.*$1\(([^)]*)\).*/\1/p; q }" $3 | cut -d, -f$2 | sed -r "s/^ *'(.*)' *$/\1/"
+}
+
+# extrai dados dos ganhadores do xml numa única passagem via extensão "concursos"
+ganhadores_xml() {
+  local sep=' '
+  if [[ $1 == '-separator' ]]; then
+    sep="$2"
+    shift 2
+  fi
+  sqlite3 -init ./sqlite/onload -separator "$sep" :memory: "$*"
+}
+
 declare -r html='D_MEGA.HTM'              # html baixado do website
 declare -r xml='MEGA.XML'                 # xml baseado no html
 declare -r db_file='megasena.sqlite'      # container do db SQLite
 declare -r db_renew='sql/db-renew.sql'    # script para criar/regenerar o db
-declare -r data_load='sql/data-load.sql'  # script de importação de dados do db
+declare -r data_load='sql/data-load.sql'  # script de sincronização do db
+declare -r data_check='sql/data-check.sql' # script de comparação do db e xml
 declare -r xsl='xsl/list-builder.xsl'     # xsl gerador dos dados do db
-declare -r xox='sql/ganhadores.sql'       # script para atualizar "ganhadores"
-declare -r oxo='xsl/ganhadores.xsl'       # xsl gerador de dados de "ganhadores"
-declare -r lst='xsl/localidades.xsl'      # xsl listador de localidades de "ganhadores"
+declare -r serving='sql/serving.sql'      # script de configuração do db em WAL
+declare -r calendario='sql/calendario.sql' # exceções ao calendário dos sorteios
+declare -r serie='megasena.mega'          # série dos concursos em formato binário
 
 # endereço do zipfile remoto container do arquivo html
 declare -r url='http://www1.caixa.gov.br/loterias/_arquivos/loterias/D_megase.zip'
@@ -148,25 +160,20 @@ declare -r count_n_db='SELECT COUNT(concurso) FROM concursos'
 
 if [[ $force_update == false ]] && [[ -e $xml ]]; then
 
-  # Pesquisa a data presumida do sorteio mais recente dado que são
-  # realizados normalmente às quartas-feiras e sábados às 20:30
-  read u F H M <<< $(date '+%u %F %H %M')
-  if (( $u % 3 != 0 )) || (( $H < 20 )) || ((( $H == 20 )) && (( $M < 30 )))
-  then
-    (( $u % 7 < 4 )) && weekday='saturday' || weekday='wednesday'
-    F=$(TZ=$tz date -d "last $weekday" '+%F')
-  fi
-
-  echo -e '\nData presumida do sorteio mais recente: '$(long_date $F)'.'
-
   # extrai a data do último registro no xml
   data=$(xpath $data_ultimo_concurso)
 
+  # pesquisa a data presumida do sorteio mais recente conforme o calendário
+  # dos sorteios e suas exceções registradas no db, testando se é posterior à
+  # data do último registro no xml
+  [[ -e $db_file ]] && db=$db_file || db=':memory:'
+  read F atrasado <<< $(sqlite3 -init ./sqlite/onload -cmd ".read $calendario" -separator ' ' $db "SELECT DATESTR(t), DAYNUM(t) > DAYNUM('$(full_date $data)') FROM (SELECT ULTIMO_SORTEIO(CAST(STRFTIME('%s') AS INTEGER), 'calendario_sorteios') AS t)")
+
+  echo -e '\nData presumida do sorteio mais recente: '$(long_date $F)'.'
+
   # se a data presumida do sorteio mais recente for posterior à data
   # do último registro no xml então força a atualização do zipfile
-  if (( $(unixtime $F) > $(unixtime $data) )); then
-    force_update=true
-  fi
+  (( $atrasado )) && force_update=true
 
 fi
 
@@ -214,26 +221,18 @@ if [[ $force_update == true ]] || [[ ! -e $xml ]]; then
       # se a quantidade de registros no db é igual a quantidade de
       # registros no xml recém criado ou atualizado
       if (( $(sqlite $count_n_db) == $k )); then
-        # extrai o separador de campos declarado no script
-        SEP=$(value_of 'separator' $data_load)
-        # obtêm o último registro no db
-        dbrec=$(sqlite -separator "$SEP" 'SELECT * FROM concursos WHERE concurso IS (SELECT MAX(concurso) FROM concursos)')
-        # extrai o último registro do xml e formata como se obtido via SQLite
-        xmlrec=$(xsltproc --param OFFSET $k --stringparam SEPARATOR "$SEP" $xsl $xml | sed -r 's/([^0-9.-])0+([1-9])/\1\2/g; s/(\.[0-9])0+/\1/g; s/NULL//g')
-        # se o último registro de concurso no db for igual ao último registro
-        # de concurso no xml então prepara o teste da lista de localidades dos
-        # ganhadores montada pelo db e da lista de localidades dos ganhadores
-        # extraída do xml via XSLT
-        if [[ $dbrec == $xmlrec ]]; then
-          dbrec=$(sqlite 'SELECT GROUP_CONCAT(IFNULL(cidade, "") || "::" || IFNULL(uf, ""), "|") FROM ganhadores WHERE concurso IS (SELECT MAX(concurso) FROM concursos)')
-          k=$(xpath $numero_ultimo_concurso)
-          xmlrec=$(xsltproc --stringparam FIELDS_SEPARATOR "::" --stringparam RECORDS_SEPARATOR "|" --param CONCURSO $k $lst $xml)
-        fi
-        # se as strings não são iguais então força a sincronização do db
-        # eliminando seu último registro
-        if [[ $dbrec != $xmlrec ]]; then
-          sqlite 'DELETE FROM concursos WHERE concurso IS (SELECT MAX(concurso) FROM concursos)'
-        fi
+        # monta o buffer com todos os registros do xml no path declarado no
+        # script de comparação
+        buffer=$(value_of 'import' $data_check)
+        SEP=$(value_of 'separator' $data_check)
+        xsltproc --param OFFSET 1 --stringparam SEPARATOR "$SEP" $xsl $xml > $buffer
+        # compara os checksums das tabelas "concursos" e "ganhadores" do db
+        # com os checksums dos dados extraídos do xml, anexando o db a uma
+        # conexão em memória que carrega a extensão "crypt"
+        igual=$(sqlite3 -init ./sqlite/onload -cmd '.load ./sqlite/crypt.so' -cmd "ATTACH '$db_file' AS db" -cmd ".parameter set @xml $xml" :memory: ".read $data_check")
+        # se os checksums não são iguais então força a sincronização do db,
+        # que atualiza somente os concursos revisados conforme seus digests
+        (( ${igual:-0} )) || revisado=true
       fi
     fi
   fi
@@ -252,6 +251,19 @@ printf '       data do sorteio: %s\n' "$(long_date $data)"
 
 # MANUTENÇÃO DO DB
 
+# força a reconstrução do db criado com esquema anterior às colunas requeridas
+# pela sincronização incremental, cujo script falharia em todas as declarações
+# que as referenciam, ou cuja coluna "cidade_norm" é gerada via extensão
+if [[ -e $db_file ]] && [[ $rebuild_db == false ]]; then
+  colunas=$(sqlite "SELECT (SELECT COUNT(*) FROM pragma_table_xinfo('concursos') WHERE name IN ('digest', 'dia')) + (SELECT COUNT(*) FROM pragma_table_xinfo('ganhadores') WHERE name == 'cidade_norm' AND hidden == 0)")
+  if (( ${colunas:-0} < 3 )); then
+    printf '\nInformação: O esquema do db "%s" é obsoleto, portanto o db será reconstruído.\n' $db_file
+    rebuild_db=true
+  fi
+fi
+
+# monta os buffers com todos os registros do xml, pois a sincronização compara
+# os digests de todos os concursos
 monta_buffer() {
   printf '\n\tXML ---( XSLT )--> Text'
   # extrai o path do buffer declarado no script
@@ -259,25 +271,25 @@ monta_buffer() {
   # extrai o separador de campos declarado no script
   local SEP=$(value_of 'separator' $data_load)
   # monta o buffer de preenchimento da tabela "concursos"
-  xsltproc --param OFFSET $1 --stringparam SEPARATOR "$SEP" $xsl $xml > $buffer
+  xsltproc --param OFFSET 1 --stringparam SEPARATOR "$SEP" $xsl $xml > $buffer
   # obtem parâmetros e monta o buffer de preenchimento da tabela "ganhadores"
-  buffer=$(value_of 'import'  $xox)
-  SEP=$(value_of 'separator'  $xox)
-  xsltproc --stringparam SEPARATOR "$SEP" $oxo $xml > $buffer
+  buffer=$(argument_of 'IMPORTA_GANHADORES' 1 $data_load)
+  SEP=$(argument_of 'IMPORTA_GANHADORES' 2 $data_load)
+  ganhadores_xml -separator "$SEP" "SELECT concurso, cidade, uf FROM ganhadores_xml('$xml')" > $buffer
 }
 
 processa_buffer() {
   printf ' ---( SQLite )---> DB'
-  # preenche ou completa a tabela "concursos"
-  sqlite ".read $data_load" > /dev/null
-  # esvazia a tabela "ganhadores" se não houve criação/regeneração do db
-  [[ $2 == true ]] && sqlite 'DELETE FROM ganhadores'
-  # preenche a tabela "ganhadores"
-  sqlite ".read '$xox'" > /dev/null
+  # preenche, completa ou revisa as tabelas "concursos" e "ganhadores"
+  local revisados ganhadores
+  IFS='|' read revisados ganhadores <<< $(sqlite ".read $data_load")
   # compara as quantidades de registros do xml e do db
   m=$(sqlite $count_n_db)
   (( $n == $m )) && local status='bem' || local status='mal'
   printf '\n\n%s do db "%s" foi %s sucedida.\n' $1 $db_file $status
+  if (( ${revisados:-0} > 0 )); then
+    Printf "\nConcursos revisados: %'d\n" $revisados
+  fi
 }
 
 if [[ $rebuild_db == true ]] || [[ ! -e $db_file ]]; then
@@ -288,21 +300,21 @@ if [[ $rebuild_db == true ]] || [[ ! -e $db_file ]]; then
 
   sqlite ".read $db_renew" > /dev/null
 
-  monta_buffer 1  # todos os dados do xml
+  monta_buffer
 
-  processa_buffer $operation false
+  processa_buffer $operation
 
 else  # ATUALIZAÇÃO DO DB
 
   m=$(sqlite $count_n_db)
 
-  # atualiza o db somente se a quantidade de registros no db
-  # é estritamente menor que a quantidade de registros no xml
-  if (( $m < $n )); then
+  # atualiza o db somente se a quantidade de registros no db é estritamente
+  # menor que a quantidade de registros no xml ou se o xml foi revisado
+  if (( $m < $n )) || [[ $revisado ]]; then
 
-    monta_buffer $(( m + 1 ))  # dados complementares do xml
+    monta_buffer
 
-    processa_buffer 'Sincronização' true
+    processa_buffer 'Sincronização'
 
   else
     printf '\nNão foi necessário sincronizar o db "%s".\n' $db_file
@@ -313,6 +325,16 @@ else  # ATUALIZAÇÃO DO DB
 
 fi
 
+# habilita leitores concorrentes ao escritor, se ainda não habilitados
+sqlite ".read $serving" > /dev/null
+
+# complementa ou recria o arquivo da série para leitura via mmap por R e afins,
+# avisando se a gravação falhou, pois os leitores manteriam a série obsoleta
+exportados=$(sqlite3 -init ./sqlite/onload $db_file "SELECT EXPORTA_SERIE('$serie')")
+if [[ ! $exportados =~ ^[0-9]+$ ]]; then
+  printf '\nAtenção: falha na exportação da série para o arquivo "%s".\n' $serie
+fi
+
 currency() {
   Printf "R$ %'d" ${1%.*}
   local f=${1#*.}
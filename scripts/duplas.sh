@@ -2,7 +2,15 @@
 #
 # listagem de todas as combinações de duas dezenas que ocorreram ao longo do
 # tempo, agrupadas por frequência e ordenadas em ordem crescente de número de
-# ocorrências
+# ocorrências, via servidor de consultas "sqlite/servidor" se está em execução,
+# senão se o socket é remanescente de servidor encerrado abruptamente i.e.; o
+# cliente termina com status 2, via sqlite3
+#
+if [[ -S /tmp/megasena.sock ]]; then
+  ./sqlite/cliente frequencias_duplas
+  status=$?
+  (( status == 2 )) || exit $status
+fi
 #
 datafile="/tmp/duplas.dat"
 #
@@ -1,7 +1,19 @@
 #!/bin/bash
 #
-# máximas latências de cada número da megasena ao longo do tempo
+# máximas latências de cada número da megasena ao longo do tempo, via servidor
+# de consultas "sqlite/servidor" se está em execução, senão se o socket é
+# remanescente de servidor encerrado abruptamente i.e.; o cliente termina com
+# status 2, via sqlite3
 #
+if [[ -S /tmp/megasena.sock ]]; then
+  ultimo=$(./sqlite/cliente ultimo_concurso)
+  status=$?
+  if (( status != 2 )); then
+    (( status == 0 )) || exit $status
+    echo "-- $ultimo"
+    exec ./sqlite/cliente latencias_maximas
+  fi
+fi
 sqlite3 megasena.sqlite 'SELECT "-- " || MAX(concurso) FROM concursos'
 for (( n=1; n<=60; n++ ))
 do
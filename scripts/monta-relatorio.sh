@@ -1,6 +1,15 @@
 #!/bin/bash
+#
+# Monta o relatório das estatísticas e inferências dos concursos em duas
+# etapas: todas as seções são calculadas uma única vez no modelo em memória
+# R, i.e.; o array associativo de valores em texto plano indexados por
+# "seção.chave", que então é serializado concorrentemente como documento
+# HTML, JSON e CSV, tal que outros consumidores leem os artefatos em cache
+# sem requisitar o db.
 
 declare -r html='megasena.html'
+declare -r json='megasena.json'
+declare -r csv='megasena.csv'
 declare -r css_file='css/frequencias.css'
 
 long_date () {
@@ -15,39 +24,29 @@ query_db () {
   sqlite3 -init ./sqlite/onload megasena.sqlite "$@"
 }
 
+png_compress() {
+  local tmpfile=/tmp/saida.png
+  # renderiza texto sobre o número do concurso no canto inferior direito e
+  # converte a imagem PNG de true-color para indexed 256 colors
+  1>/dev/null which convert && convert -pointsize 11 -fill '#778899' -gravity SouthEast -draw "text 1,1 'Concurso $num_concurso da MegaSena.'" -quality 0 +dither -colors 256 "$1" $tmpfile
+  # compressão default da imagem resultante
+  1>/dev/null which pngcrush && pngcrush -q $tmpfile "$1"
+}
+
+declare -A R
+declare -r tmp_dir=$(mktemp -d)
+trap "rm -rf $tmp_dir" EXIT
+
+# -- etapa de cálculo
+
 n=$(sqlite3 megasena.sqlite "SELECT count(concurso) FROM concursos")
 num_concurso=$n
+R[concursos]=$n
 
-cat > $html <<DOC
-<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Transitional//EN" "http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd">
-<html xmlns="http://www.w3.org/1999/xhtml" lang="pt_BR">
-<head>
-<title>Análise dos Números Sorteados nos $n Concursos da Mega-sena</title>
-<meta http-equiv="Content-Type" content="text/html; charset=UTF-8" />
-<meta name="authorship" content="@sergio_cps" />
-<link rel="stylesheet" type="text/css" media="screen" href="css/megasena.css" />
-<link rel="stylesheet" type="text/css" media="screen" href="css/frequencias.css" />
-<script type="text/javascript" src="js/mootools-core-1.4.5-full-compat-yc.js"></script>
-<script type="text/javascript" src="js/mootools-more-1.4.0.1.js"></script>
-<script type="text/javascript" src="js/megasena.js"></script>
-</head>
-<body>
-  <div id="conteudo">
-    <h1>análise dos números sorteados<br/>nos <em>$n</em> concursos da mega-sena</h1>
-    <table class="boleto">
-      <caption>frequências e latências das dezenas</caption>
-      <tfoot>
-        <tr>
-          <td colspan="10"><span>Observação:</span><span>Quanto mais intensa a cor de fundo da célula, maior é a frequência da dezena que contém e quanto<br/> mais intensa a cor dos dígitos da dezena, mais recentemente essa dezena foi sorteada.</span></td>
-        </tr>
-      </tfoot>
-      <tbody>
-DOC
-
-query_db "
-DROP TABLE IF EXISTS view_to_build_html;
-CREATE TABLE view_to_build_html
-AS SELECT
+# boleto das frequências e latências das dezenas renderizado pela função
+# agregada RENDER_BOLETO da extensão "concursos", mais os dados das dezenas
+query_db <<SQL
+CREATE TEMP VIEW boleto AS SELECT
     dezena, frequencia, latencia,
     (latencia+max_latencia/2.0)*100/frequencia/frequencia AS ifrap,
     0.2+0.8*((frequencia-min_frequencia)/amplitude) AS alfa,
@@ -58,104 +57,41 @@ AS SELECT
        MAX(frequencia)-MIN(frequencia) AS amplitude,
        MAX(latencia) AS max_latencia,
        5/12.0 AS exponent
-      FROM info_dezenas);"
-
-[[ -e $css_file ]] && rm -f $css_file
-touch $css_file
-
-for (( dezena=1, row=1; row <= 6; row++ ))
-do
-  cat >> $html <<DOC
-        <tr>
-DOC
-  for (( column=1; column <= 10; column++, dezena++ ))
-  do
-    read frequencia latencia ifrap alfa beta <<< $(query_db "
-      SELECT frequencia, latencia, round(ifrap,5), alfa, beta
-      FROM view_to_build_html
-      WHERE dezena == $dezena")
-    printf -v dec '%02d' $dezena
-    classname="dezena$dec"
-    cat >> $html <<DOC
-    <td class="$classname" title="dezena $dec&lt;br/&gt;IFR = ${ifrap} :: foi sorteada em $frequencia concursos e pela última vez há $latencia concursos">$dec</td>
-DOC
-    [[ $beta == '1.0' ]] && cor='0' || cor='18'
-    cat >> $css_file <<CSS_DOC
-td.$classname {
-  background-color: rgba(240,80,0,$alfa);
-  color: rgba($cor,$cor,$cor,$beta);
-}
-CSS_DOC
-  done
-  cat >> $html <<DOC
-        </tr>
-DOC
-done
-
-query_db 'DROP TABLE IF EXISTS view_to_build_html'
-
-cat >> $html <<DOC
-      </tbody>
-    </table>
-DOC
+      FROM info_dezenas);
+.output $tmp_dir/boleto.html
+SELECT RENDER_BOLETO(dezena, frequencia, latencia, round(ifrap,5), alfa, beta) FROM boleto;
+.output $tmp_dir/boleto.css
+SELECT RENDER_BOLETO(dezena, frequencia, latencia, round(ifrap,5), alfa, beta, 'css') FROM boleto;
+.output $tmp_dir/boleto.dat
+SELECT dezena, frequencia, latencia, round(ifrap,5) FROM boleto ORDER BY dezena;
+SQL
+R[boleto.html]=$(< $tmp_dir/boleto.html)
+R[boleto.css]=$(< $tmp_dir/boleto.css)
+R[boleto.dezenas]=$(sed '/^$/d' $tmp_dir/boleto.dat)
 
 # cria gráfico das frequências e latências
 ./R/plot-both.R
-
-png_compress() {
-  local tmpfile=/tmp/saida.png
-  # renderiza texto sobre o número do concurso no canto inferior direito e
-  # converte a imagem PNG de true-color para indexed 256 colors
-  1>/dev/null which convert && convert -pointsize 11 -fill '#778899' -gravity SouthEast -draw "text 1,1 'Concurso $num_concurso da MegaSena.'" -quality 0 +dither -colors 256 "$1" $tmpfile
-  # compressão default da imagem resultante
-  1>/dev/null which pngcrush && pngcrush -q $tmpfile "$1"
-}
-
 png_compress "img/both-$n.png"
-cat >> $html <<DOC
-    <h2>Diagramas das frequências e latências</h2>
-    <div>
-      <img src="img/both-$n.png" alt="frequências e latências" height="600" width="1100" />
-    </div>
-DOC
 
-probability='5%'
-critical='77.931'
-read n chi status <<< $(sqlite3 -separator ' ' megasena.sqlite "SELECT n, round(chi,3), (chi >= $critical) FROM (SELECT n, sum(desvio*desvio/esperanca) AS chi FROM (SELECT n, esperanca, (frequencia-esperanca) AS desvio FROM info_dezenas, (SELECT n, n/10.0 AS esperanca FROM (SELECT count(concurso) AS n from concursos))))")
-R/plot-chi-59.R $chi
+R[aderencia.significancia]='5%'
+R[aderencia.critico]='77.931'
+R[aderencia.gl]=59
+read 'R[aderencia.n]' 'R[aderencia.chi]' 'R[aderencia.rejeita]' <<< $(sqlite3 -separator ' ' megasena.sqlite "SELECT n, round(chi,3), (chi >= ${R[aderencia.critico]}) FROM (SELECT n, sum(desvio*desvio/esperanca) AS chi FROM (SELECT n, esperanca, (frequencia-esperanca) AS desvio FROM info_dezenas, (SELECT n, n/10.0 AS esperanca FROM (SELECT count(concurso) AS n from concursos))))")
+R/plot-chi-59.R ${R[aderencia.chi]}
 png_compress 'img/chi-59.png'
-cat >> $html <<DOC
-    <h2>Teste de Aderência <span>&#967;&#178;<!-- 0x03C7 0x00B2 χ² --></span></h2>
-    <div>
-      <p title="&lt;strong&gt;hipótese nula&lt;/strong&gt; :: ao longo do tempo as dezenas são sorteadas o mesmo número de vezes">H₀: <span>As dezenas têm distribuição uniforme.</span></p>
-      <p title="&lt;strong&gt;hipótese alternativa&lt;/strong&gt; ::  ao longo do tempo as dezenas não são sorteadas o mesmo número de vezes">H₁: <span>As dezenas não têm distribuição uniforme.</span></p>
-      <p><img src="img/chi-59.png" alt="distribuição chi-quadrado" width="640" height="480" /></p>
-      <p><span class="chi">&#967;&#178;</span> amostral = <em>$chi</em></p>
-      <p>gl=<em>59</em></p>
-      <p>Para X ∼ <span class="chi">&#967;&#178;</span> , gl=<em>59</em> temos: P(X ≥ <em>$critical</em>) = <em>$probability</em></p>
-      <p>portanto: P(X ≥ <em>$chi</em>) $( [ $status -ne 1 ] && echo '&gt;' || echo '&lt;' ) <em>$probability</em>.</p>
-      <p>Conclusão: <span>“Ao nível de significância de $probability $( [ $status -ne 1 ] && echo 'não ' )rejeitamos a hipótese nula”.</span></p>
-    </div>
-DOC
 
-tmp='/tmp/buffer.txt'
+tmp="$tmp_dir/buffer.txt"
 # monta e armazena a máscara de incidência das dezenas de cada concurso que
 # contém ao menos uma sequência de duas dezenas consecutivas
 query_db 'SELECT zeropad(concurso,4), MASK60(dezenas) AS mask FROM dezenas_juntadas WHERE mask LIKE "%11%"' | sed '/^$/d' > $tmp
-cat >> $html <<DOC
-    <h2>Sequências de dezenas consecutivas</h2>
-    <ul>
-    <li>Em <em>$(sed -n '$=' $tmp)</em> concursos ocorreram sequências de <em>2+</em> (duas ou mais) dezenas.</li>
-    <li>Em <em>$(cut -d' ' -f2 $tmp | grep -Ec '111+')</em> concursos ocorreram sequências de <em>3+</em> dezenas.</li>
-    <li>Em <em>$(cut -d' ' -f2 $tmp | grep -Ec '1111+')</em> concursos ocorreram sequências de <em>4+</em> dezenas.</li>
-    <li>Em <em>$(cut -d' ' -f2 $tmp | grep -Ec '11+.+11+')</em> concursos ocorreram <em>2</em> sequências distintas de <em>2+</em> dezenas.</li>
-DOC
+R[sequencias.2+]=$(grep -c '' $tmp)
+R[sequencias.3+]=$(cut -d' ' -f2 $tmp | grep -Ec '111+')
+R[sequencias.4+]=$(cut -d' ' -f2 $tmp | grep -Ec '1111+')
+R[sequencias.distintas]=$(cut -d' ' -f2 $tmp | grep -Ec '11+.+11+')
 
-cat >> $html <<DOC
-    <li>Frequências de sequências de 2 dezenas:
-      <ul>
-DOC
-query_db "select zeropad(frequencia,2), group_concat(dupla, ' ')
+# frequências das sequências de 2 dezenas, uma frequência por linha seguida
+# das respectivas duplas
+R[sequencias.duplas]=$(query_db "select zeropad(frequencia,2), group_concat(dupla, ' ')
 from (
   SELECT ' ('||zeropad(dezena,2)||'-'||zeropad(dezena+1,2)||') ' AS dupla, count(concurso) AS frequencia
   FROM dezenas_juntadas, (
@@ -166,22 +102,11 @@ from (
   )
   WHERE (dezenas & mask) == mask
   GROUP BY dezena
-) GROUP BY frequencia ORDER BY frequencia desc" | sed '/^$/d' | while read f m
-do
-  cat >> $html <<DOC
-      <li>$f:<em>$m</em></li>
-DOC
-done
-cat >> $html <<DOC
-      </ul>
-    </li>
-DOC
+) GROUP BY frequencia ORDER BY frequencia desc" | sed '/^$/d')
 
-cat >> $html <<DOC
-    <li>Dezenas consecutivas recentes:
-      <ul>
-DOC
-while read concurso mask
+# dezenas consecutivas dos 10 concursos mais recentes, um concurso por linha
+# seguido das dezenas das suas sequências
+R[sequencias.recentes]=$(while read concurso mask
 do
   unset lista
   while IFS=':' read offset submask
@@ -190,32 +115,18 @@ do
       lista=( ${lista[@]} $offset )
     done
   done < <(echo $mask | grep -Eob '11+')
-  cat >> $html <<DOC
-      <li>Concurso <em>$concurso</em>: $(printf ' <em>%02d</em>' ${lista[@]}).</li>
-DOC
-done < <(tail -n 10 $tmp)
-cat >> $html <<DOC
-      </ul>
-    </li>
-    </ul>
-DOC
+  echo $(( 10#$concurso )) ${lista[@]}
+done < <(tail -n 10 $tmp))
 
 query_db 'SELECT replace(GROUP_CONCAT(bitstatus(dezenas, dezena-1), ""),"0"," ") FROM (SELECT DISTINCT dezena FROM dezenas_sorteadas), dezenas_juntadas GROUP BY dezena' > $tmp
-cat >> $html <<DOC
-    <h2>Reincidência de dezenas em concursos consecutivos</h2>
-    <ul>
-    <li>Ocorreram <em>$(grep -Eo '\b1{2,}\b' $tmp | wc -l)</em> reincidências de todas as dezenas em <em>2+</em> concursos consecutivos.</li>
-DOC
+R[reincidencias.total]=$(grep -Eo '\b1{2,}\b' $tmp | wc -l)
 for (( j=2; j<=4; j++ ))
 do
-  lista=$(grep -Eno "\b1{$j}\b" $tmp | cut -d ':' -f 1 | uniq -c | sort -nr | head -n 10 | sed -r 's/^.+\s//')
-  cat >> $html <<DOC
-    <li>Dezenas mais reincidentes em <em>$j</em> concursos consecutivos: $(printf ' <em>%02d</em>' $lista).</li>
-DOC
+  R[reincidencias.$j]=$(echo $(grep -Eno "\b1{$j}\b" $tmp | cut -d ':' -f 1 | uniq -c | sort -nr | head -n 10 | sed -r 's/^.+\s//'))
 done
 
-n=20
-lista=$(query_db "SELECT '<em>'||zeropad(dezena,2)||'</em>'
+R[reincidencias.janela]=20
+R[reincidencias.recentes]=$(echo $(query_db "SELECT dezena
 FROM (
   SELECT dezena, GROUP_CONCAT(bitstatus(dezenas, dezena-1),'') AS mask
   FROM (
@@ -223,32 +134,20 @@ FROM (
   ), (
     SELECT dezenas
     FROM dezenas_juntadas
-    WHERE concurso >= (SELECT MAX(concurso)-$n+1 FROM concursos)
+    WHERE concurso >= (SELECT MAX(concurso)-${R[reincidencias.janela]}+1 FROM concursos)
   )
   GROUP BY dezena HAVING mask LIKE '%11%'
 )
-ORDER BY REVERSE(REPLACE(REPLACE(REPLACE(REPLACE(REPLACE(mask,'1111','AAAA'),'111','AAA'),'11','AA'),'1','0'),'A','1')) DESC")
-[[ $lista ]] && cat >> $html <<DOC
-    <li>Dezenas reincidentes nos <em>$n</em> últimos concursos: $lista.</li>
-DOC
-cat >> $html <<DOC
-    </ul>
-DOC
-
-read n m p desvio <<< $(query_db 'SELECT n, m, replace(round(p*100,3),".",","), replace(round(d*100,3),".",",") FROM (SELECT n, m, p, power(p*q/n, .5) AS d FROM (SELECT n, m, p, 1-p AS q FROM (SELECT m, n, m/1.0/n AS p FROM (SELECT sum(acumulado) AS m, count(acumulado) AS n FROM concursos))))')
-cat >> $html <<DOC
-    <h2>Concursos acumulados</h2>
-    <ul>
-    <li>A mega-sena acumulou em <em>$m</em> concursos dos <em>$n</em> realizados, portanto estimamos: <span>Probabilidade de um concurso acumular = <em>${p}%</em>&nbsp;±&nbsp;<em>${desvio}%</em>.</span></li>
-DOC
+ORDER BY REVERSE(REPLACE(REPLACE(REPLACE(REPLACE(REPLACE(mask,'1111','AAAA'),'111','AAA'),'11','AA'),'1','0'),'A','1')) DESC"))
 
-sqlite3 megasena.sqlite "SELECT replace(replace(group_concat(acumulado, ''), '01', '0'||X'0A'||'1'), '10', '1'||X'0A'||'0') FROM concursos" | sort | uniq -c | sed -r 's/^\s*//g' | while read f m
-                 do
-                   echo ${m:0:1} ${#m} $f
-                 done > '/tmp/frequencias.dat'
+read 'R[acumulados.n]' 'R[acumulados.m]' 'R[acumulados.p]' 'R[acumulados.desvio]' <<< $(query_db 'SELECT n, m, round(p*100,3), round(d*100,3) FROM (SELECT n, m, p, power(p*q/n, .5) AS d FROM (SELECT n, m, p, 1-p AS q FROM (SELECT m, n, m/1.0/n AS p FROM (SELECT sum(acumulado) AS m, count(acumulado) AS n FROM concursos))))')
 
-read n media desvio f m <<< $(sqlite3 -init ./sqlite/workaround megasena.sqlite "CREATE TEMP VIEW IF NOT EXISTS acc1 AS SELECT dim, freq FROM acc WHERE tipo IS 1;
-SELECT N, replace(round(media,3),'.',','), replace(round(desvio,3),'.',','), f, m
+# amplitudes dos períodos em que acumulou por 1+ concursos consecutivos e
+# suas frequências, via sequências de valores da coluna "acumulado"
+read 'R[acumulados.periodos]' 'R[acumulados.media]' 'R[acumulados.desvio_media]' 'R[acumulados.maior_vezes]' 'R[acumulados.maior]' <<< $(query_db "CREATE TEMP VIEW acc1 AS
+  SELECT comprimento AS dim, count(*) AS freq FROM runs('acumulado')
+  WHERE valor IS 1 GROUP BY comprimento;
+SELECT N, round(media,3), round(desvio,3), f, m
 FROM (
   SELECT
     N, f, m, media,
@@ -264,24 +163,15 @@ FROM (
       SELECT (SELECT max(dim) FROM acc1) AS m, freq AS f FROM acc1 WHERE dim IS m
     ), acc1
   ), acc1);")
-cat >> $html <<DOC
-    <li>Com base nos <em>$n</em> períodos distintos nos quais acumulou por <em>1+</em> concursos consecutivos, estimamos: <span>Média das amplitudes de períodos cumulativos = <em>$media</em>&nbsp;±&nbsp;<em>$desvio</em> concursos.</span></li>
-    <li>A maior amplitude observada; <em>$m</em> concursos acumulados consecutivos, ocorreu por <em>$f</em> vêzes.</li>
-DOC
 
-m=$(sqlite3 megasena.sqlite 'SELECT (SELECT max(concurso) FROM concursos) -  max(concurso) FROM concursos WHERE not acumulado');
-(( m > 0 )) && cat >> $html <<DOC
-    <li>A megasena está acumulada há <em>$m</em> concursos.</li>
-DOC
+R[acumulados.atual]=$(sqlite3 megasena.sqlite 'SELECT (SELECT max(concurso) FROM concursos) -  max(concurso) FROM concursos WHERE not acumulado');
 
-cat >> $html <<DOC
-    </ul>
-DOC
-
-critical='3.841'
-read chi status <<< $(query_db "CREATE TEMP TABLE t2 AS
+R[independencia.significancia]='5%'
+R[independencia.critico]='3.841'
+R[independencia.gl]=1
+read 'R[independencia.chi]' 'R[independencia.rejeita]' <<< $(query_db "CREATE TEMP TABLE t2 AS
   SELECT concurso FROM dezenas_juntadas WHERE mask60(dezenas) LIKE '%11%';
-SELECT round(chi,3), (chi >= $critical)
+SELECT round(chi,3), (chi >= ${R[independencia.critico]})
 FROM (
   SELECT power(fa-ea,2)/ea + power(fb-eb,2)/eb + power(fc-ec,2)/ec + power(fd-ed,2)/ed AS chi
   FROM (
@@ -305,23 +195,137 @@ FROM (
     )
   )
 )")
-R/plot-chi-one.R $chi
+R/plot-chi-one.R ${R[independencia.chi]}
 png_compress 'img/chi-one.png'
-cat >> $html <<DOC
+
+# -- etapa de serialização
+
+# lista de dezenas com zeros à esquerda, cada uma como <em>NN</em>
+em_dezenas () {
+  (( $# )) && printf ' <em>%02d</em>' $@
+}
+
+# conclusão do teste de hipótese da seção informada
+conclusao () {
+  local p=${R[$1.significancia]}
+  if (( ${R[$1.rejeita]} )); then
+    cat <<DOC
+      <p>portanto: P(X ≥ <em>${R[$1.chi]}</em>) &lt; <em>$p</em>.</p>
+      <p>Conclusão: <span>“Ao nível de significância de $p rejeitamos a hipótese nula”.</span></p>
+DOC
+  else
+    cat <<DOC
+      <p>portanto: P(X ≥ <em>${R[$1.chi]}</em>) &gt; <em>$p</em>.</p>
+      <p>Conclusão: <span>“Ao nível de significância de $p não rejeitamos a hipótese nula”.</span></p>
+DOC
+  fi
+}
+
+emite_html () {
+  local n=${R[concursos]} f m concurso lista
+
+  printf '%s\n' "${R[boleto.css]}" > $css_file
+
+  cat <<DOC
+<!DOCTYPE html PUBLIC "-//W3C//DTD XHTML 1.0 Transitional//EN" "http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd">
+<html xmlns="http://www.w3.org/1999/xhtml" lang="pt_BR">
+<head>
+<title>Análise dos Números Sorteados nos $n Concursos da Mega-sena</title>
+<meta http-equiv="Content-Type" content="text/html; charset=UTF-8" />
+<meta name="authorship" content="@sergio_cps" />
+<link rel="stylesheet" type="text/css" media="screen" href="css/megasena.css" />
+<link rel="stylesheet" type="text/css" media="screen" href="css/frequencias.css" />
+<script type="text/javascript" src="js/mootools-core-1.4.5-full-compat-yc.js"></script>
+<script type="text/javascript" src="js/mootools-more-1.4.0.1.js"></script>
+<script type="text/javascript" src="js/megasena.js"></script>
+</head>
+<body>
+  <div id="conteudo">
+    <h1>análise dos números sorteados<br/>nos <em>$n</em> concursos da mega-sena</h1>
+    <table class="boleto">
+      <caption>frequências e latências das dezenas</caption>
+      <tfoot>
+        <tr>
+          <td colspan="10"><span>Observação:</span><span>Quanto mais intensa a cor de fundo da célula, maior é a frequência da dezena que contém e quanto<br/> mais intensa a cor dos dígitos da dezena, mais recentemente essa dezena foi sorteada.</span></td>
+        </tr>
+      </tfoot>
+${R[boleto.html]}
+    </table>
+    <h2>Diagramas das frequências e latências</h2>
+    <div>
+      <img src="img/both-$n.png" alt="frequências e latências" height="600" width="1100" />
+    </div>
+    <h2>Teste de Aderência <span>&#967;&#178;<!-- 0x03C7 0x00B2 χ² --></span></h2>
+    <div>
+      <p title="&lt;strong&gt;hipótese nula&lt;/strong&gt; :: ao longo do tempo as dezenas são sorteadas o mesmo número de vezes">H₀: <span>As dezenas têm distribuição uniforme.</span></p>
+      <p title="&lt;strong&gt;hipótese alternativa&lt;/strong&gt; ::  ao longo do tempo as dezenas não são sorteadas o mesmo número de vezes">H₁: <span>As dezenas não têm distribuição uniforme.</span></p>
+      <p><img src="img/chi-59.png" alt="distribuição chi-quadrado" width="640" height="480" /></p>
+      <p><span class="chi">&#967;&#178;</span> amostral = <em>${R[aderencia.chi]}</em></p>
+      <p>gl=<em>59</em></p>
+      <p>Para X ∼ <span class="chi">&#967;&#178;</span> , gl=<em>59</em> temos: P(X ≥ <em>${R[aderencia.critico]}</em>) = <em>${R[aderencia.significancia]}</em></p>
+DOC
+  conclusao aderencia
+  cat <<DOC
+    </div>
+    <h2>Sequências de dezenas consecutivas</h2>
+    <ul>
+    <li>Em <em>${R[sequencias.2+]}</em> concursos ocorreram sequências de <em>2+</em> (duas ou mais) dezenas.</li>
+    <li>Em <em>${R[sequencias.3+]}</em> concursos ocorreram sequências de <em>3+</em> dezenas.</li>
+    <li>Em <em>${R[sequencias.4+]}</em> concursos ocorreram sequências de <em>4+</em> dezenas.</li>
+    <li>Em <em>${R[sequencias.distintas]}</em> concursos ocorreram <em>2</em> sequências distintas de <em>2+</em> dezenas.</li>
+    <li>Frequências de sequências de 2 dezenas:
+      <ul>
+DOC
+  while read f m
+  do
+    echo "      <li>$f:<em>$m</em></li>"
+  done <<< "${R[sequencias.duplas]}"
+  cat <<DOC
+      </ul>
+    </li>
+    <li>Dezenas consecutivas recentes:
+      <ul>
+DOC
+  while read concurso lista
+  do
+    [[ $concurso ]] && printf '      <li>Concurso <em>%04d</em>: %s.</li>\n' $concurso "$(em_dezenas $lista)"
+  done <<< "${R[sequencias.recentes]}"
+  cat <<DOC
+      </ul>
+    </li>
+    </ul>
+    <h2>Reincidência de dezenas em concursos consecutivos</h2>
+    <ul>
+    <li>Ocorreram <em>${R[reincidencias.total]}</em> reincidências de todas as dezenas em <em>2+</em> concursos consecutivos.</li>
+DOC
+  for (( j=2; j<=4; j++ ))
+  do
+    echo "    <li>Dezenas mais reincidentes em <em>$j</em> concursos consecutivos: $(em_dezenas ${R[reincidencias.$j]}).</li>"
+  done
+  [[ ${R[reincidencias.recentes]} ]] && echo "    <li>Dezenas reincidentes nos <em>${R[reincidencias.janela]}</em> últimos concursos: $(em_dezenas ${R[reincidencias.recentes]}).</li>"
+  cat <<DOC
+    </ul>
+    <h2>Concursos acumulados</h2>
+    <ul>
+    <li>A mega-sena acumulou em <em>${R[acumulados.m]}</em> concursos dos <em>${R[acumulados.n]}</em> realizados, portanto estimamos: <span>Probabilidade de um concurso acumular = <em>${R[acumulados.p]/./,}%</em>&nbsp;±&nbsp;<em>${R[acumulados.desvio]/./,}%</em>.</span></li>
+    <li>Com base nos <em>${R[acumulados.periodos]}</em> períodos distintos nos quais acumulou por <em>1+</em> concursos consecutivos, estimamos: <span>Média das amplitudes de períodos cumulativos = <em>${R[acumulados.media]/./,}</em>&nbsp;±&nbsp;<em>${R[acumulados.desvio_media]/./,}</em> concursos.</span></li>
+    <li>A maior amplitude observada; <em>${R[acumulados.maior]}</em> concursos acumulados consecutivos, ocorreu por <em>${R[acumulados.maior_vezes]}</em> vêzes.</li>
+DOC
+  (( ${R[acumulados.atual]} > 0 )) && echo "    <li>A megasena está acumulada há <em>${R[acumulados.atual]}</em> concursos.</li>"
+  cat <<DOC
+    </ul>
     <h2>Teste de Independência “Acumular x Sequência de dezenas consecutivas”</h2>
     <div>
       <p title="&lt;strong&gt;hipótese nula&lt;/strong&gt; :: concursos acumulam indiferentemente ao sorteio de dezenas consecutivas">H₀: <span>Os eventos são independentes entre si.</span></p>
       <p title="&lt;strong&gt;hipótese alternativa&lt;/strong&gt; :: quando são sorteadas dezenas consecutivas quase certamente os concursos acumulam">H₁: <span>Os eventos não são independentes entre si.</span></p>
       <p><img src="img/chi-one.png" alt="distribuição chi-quadrado" width="640" height="480" /></p>
-      <p><span class="chi">&#967;&#178;</span> amostral = <em>$chi</em></p>
+      <p><span class="chi">&#967;&#178;</span> amostral = <em>${R[independencia.chi]}</em></p>
       <p>gl = <em>1</em></p>
-      <p>Para X ∼ <span class="chi">&#967;&#178;</span> , gl=1 temos: P(X ≥ <em>$critical</em>) = <em>$probability</em></p>
-      <p>portanto: P(X ≥ <em>$chi</em>) $( [ $status -ne 1 ] && echo '&gt;' || echo '&lt;' ) <em>$probability</em>.</p>
-      <p>Conclusão: <span>“Ao nível de significância de $probability $( [ $status -ne 1 ] && echo 'não ' )rejeitamos a hipótese nula”.</span></p>
-    </div>
+      <p>Para X ∼ <span class="chi">&#967;&#178;</span> , gl=1 temos: P(X ≥ <em>${R[independencia.critico]}</em>) = <em>${R[independencia.significancia]}</em></p>
 DOC
-
-cat >> $html <<DOC
+  conclusao independencia
+  cat <<DOC
+    </div>
   </div>
   <div id="footer">
     <p>
@@ -333,3 +337,110 @@ cat >> $html <<DOC
 </body>
 </html>
 DOC
+}
+
+# lista JSON dos argumentos numéricos
+json_lista () {
+  local IFS=','
+  echo "[$*]"
+}
+
+# objeto JSON do teste de hipótese da seção informada
+json_teste () {
+  echo "{\"chi\": ${R[$1.chi]}, \"gl\": ${R[$1.gl]}, \"critico\": ${R[$1.critico]}, \"significancia\": $(printf '0.%02d' ${R[$1.significancia]%\%}), \"rejeita\": $( (( ${R[$1.rejeita]} )) && echo true || echo false )}"
+}
+
+emite_json () {
+  local d f l i m c lista sep
+
+  echo '{'
+  echo "  \"concursos\": ${R[concursos]},"
+  echo '  "dezenas": ['
+  sep=''
+  while read d f l i
+  do
+    printf '%s    {"dezena": %d, "frequencia": %d, "latencia": %d, "ifrap": %s}' "$sep" $d $f $l $i
+    sep=$',\n'
+  done <<< "${R[boleto.dezenas]}"
+  echo
+  echo '  ],'
+  echo "  \"aderencia\": $(json_teste aderencia),"
+  echo '  "sequencias": {'
+  echo "    \"2+\": ${R[sequencias.2+]}, \"3+\": ${R[sequencias.3+]}, \"4+\": ${R[sequencias.4+]}, \"distintas\": ${R[sequencias.distintas]},"
+  echo -n '    "duplas": ['
+  sep=''
+  while read f m
+  do
+    [[ $f ]] || continue
+    echo -n "$sep{\"frequencia\": $(( 10#$f )), \"duplas\": [$(grep -Eo '[0-9]+-[0-9]+' <<< "$m" | sed 's/.*/"&"/' | paste -sd ',')]}"
+    sep=', '
+  done <<< "${R[sequencias.duplas]}"
+  echo '],'
+  echo -n '    "recentes": ['
+  sep=''
+  while read c lista
+  do
+    [[ $c ]] || continue
+    echo -n "$sep{\"concurso\": $c, \"dezenas\": $(json_lista $lista)}"
+    sep=', '
+  done <<< "${R[sequencias.recentes]}"
+  echo ']'
+  echo '  },'
+  echo '  "reincidencias": {'
+  echo "    \"total\": ${R[reincidencias.total]},"
+  echo "    \"2\": $(json_lista ${R[reincidencias.2]}), \"3\": $(json_lista ${R[reincidencias.3]}), \"4\": $(json_lista ${R[reincidencias.4]}),"
+  echo "    \"janela\": ${R[reincidencias.janela]}, \"recentes\": $(json_lista ${R[reincidencias.recentes]})"
+  echo '  },'
+  echo '  "acumulados": {'
+  echo "    \"n\": ${R[acumulados.n]}, \"m\": ${R[acumulados.m]}, \"p\": ${R[acumulados.p]}, \"desvio\": ${R[acumulados.desvio]},"
+  echo "    \"periodos\": ${R[acumulados.periodos]}, \"media\": ${R[acumulados.media]}, \"desvio_media\": ${R[acumulados.desvio_media]},"
+  echo "    \"maior\": ${R[acumulados.maior]}, \"maior_vezes\": ${R[acumulados.maior_vezes]}, \"atual\": ${R[acumulados.atual]}"
+  echo '  },'
+  echo "  \"independencia\": $(json_teste independencia)"
+  echo '}'
+}
+
+emite_csv () {
+  local d f l i m c lista chave
+
+  echo 'secao,chave,valor'
+  echo "concursos,n,${R[concursos]}"
+  while read d f l i
+  do
+    printf 'dezenas,%02d.frequencia,%s\ndezenas,%02d.latencia,%s\ndezenas,%02d.ifrap,%s\n' $d $f $d $l $d $i
+  done <<< "${R[boleto.dezenas]}"
+  for chave in chi gl critico significancia rejeita; do
+    echo "aderencia,$chave,${R[aderencia.$chave]}"
+  done
+  for chave in 2+ 3+ 4+ distintas; do
+    echo "sequencias,$chave,${R[sequencias.$chave]}"
+  done
+  while read f m
+  do
+    [[ $f ]] && echo "sequencias,duplas.$f,"$(grep -Eo '[0-9]+-[0-9]+' <<< "$m")
+  done <<< "${R[sequencias.duplas]}"
+  while read c lista
+  do
+    [[ $c ]] && echo "sequencias,recentes.$c,$lista"
+  done <<< "${R[sequencias.recentes]}"
+  for chave in total 2 3 4 janela recentes; do
+    echo "reincidencias,$chave,${R[reincidencias.$chave]}"
+  done
+  for chave in n m p desvio periodos media desvio_media maior maior_vezes atual; do
+    echo "acumulados,$chave,${R[acumulados.$chave]}"
+  done
+  for chave in chi gl critico significancia rejeita; do
+    echo "independencia,$chave,${R[independencia.$chave]}"
+  done
+}
+
+# serializa o modelo via função informada num arquivo temporário que substitui
+# o artefato somente se completo, evitando leituras de artefatos parciais
+publica () {
+  $1 > "$2.tmp" && mv -f "$2.tmp" "$2"
+}
+
+publica emite_html $html &
+publica emite_json $json &
+publica emite_csv $csv &
+wait
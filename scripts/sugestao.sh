@@ -1,5 +1,21 @@
 #!/bin/bash
-for d in $(sqlite3 -init ./sqlite/onload megasena.sqlite ".read sql/rarely.sql" | cut -d " " -f 1)
+#
+# lista das dezenas com frequência abaixo do esperado e latência acima do
+# esperado conforme "sql/rarely.sql", via servidor de consultas
+# "sqlite/servidor" se está em execução, senão se o socket é remanescente de
+# servidor encerrado abruptamente i.e.; o cliente termina com status 2, via
+# sqlite3
+#
+status=2
+if [[ -S /tmp/megasena.sock ]]; then
+  dezenas=$(./sqlite/cliente sugestao)
+  status=$?
+  (( status == 0 || status == 2 )) || exit $status
+fi
+if (( status == 2 )); then
+  dezenas=$(sqlite3 -init ./sqlite/onload megasena.sqlite ".read sql/rarely.sql")
+fi
+for d in $(echo "$dezenas" | cut -d " " -f 1)
 do
   echo -n " $d"
 done
@@ -1,10 +1,18 @@
 #!/bin/bash
 #
 # Pesquisa número e data do concurso mais recente no qual uma determinada
-# dezena foi sorteada.
+# dezena foi sorteada, via servidor de consultas "sqlite/servidor" se está em
+# execução, senão se o socket é remanescente de servidor encerrado abruptamente
+# i.e.; o cliente termina com status 2, via sqlite3.
 #
 dezena=$1
 #
+if [[ -S /tmp/megasena.sock ]]; then
+  ./sqlite/cliente ultima_aparicao $dezena
+  status=$?
+  (( status == 2 )) || exit $status
+fi
+#
 sqlite3 -init ./sqlite/onload megasena.sqlite "SELECT concurso, data_sorteio, '{ ' || GROUP_CONCAT(ZEROPAD(dezena,2),' ') || ' }'
 FROM concursos natural JOIN dezenas_sorteadas
 WHERE concurso IS (SELECT MAX(concurso) FROM dezenas_juntadas WHERE bitstatus(dezenas, $dezena-1))"
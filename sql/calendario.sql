@@ -0,0 +1,8 @@
+-- Exceções ao calendário regular dos sorteios, às quartas-feiras e sábados às
+-- 20:30, consultadas pelas funções PROXIMO_SORTEIO e ULTIMO_SORTEIO da extensão
+-- "calendar" e.g.; sorteios especiais como a "Mega da Virada" e os sorteios
+-- regulares suspensos que a antecedem, que são registrados com horário NULL.
+CREATE TABLE IF NOT EXISTS calendario_sorteios (
+  data        TEXT PRIMARY KEY,   -- yyyy-mm-dd
+  horario     TEXT,               -- hh:mm ou NULL se não há sorteio na data
+  descricao   TEXT);
@@ -0,0 +1,89 @@
+-- Consultas nomeadas e parametrizadas servidas pelo servidor local de
+-- consultas "sqlite/servidor", preparadas uma única vez na inicialização.
+-- Cada consulta é precedida pela linha de comentário que a nomeia e seus
+-- parâmetros são vinculados na ordem dos argumentos informados ao cliente:
+--
+--    ./sqlite/cliente ultima_aparicao 13
+--
+-- número do concurso mais recente
+-- consulta: ultimo_concurso
+SELECT max(concurso) FROM concursos;
+
+-- número, data e dezenas do concurso mais recente no qual a dezena foi sorteada
+-- consulta: ultima_aparicao
+SELECT concurso, data_sorteio, '{ ' || GROUP_CONCAT(ZEROPAD(dezena,2),' ') || ' }'
+FROM concursos natural JOIN dezenas_sorteadas
+WHERE concurso IS (SELECT MAX(concurso) FROM dezenas_juntadas WHERE bitstatus(dezenas, ?1-1));
+
+-- máxima latência da dezena ao longo do tempo, i.e.; o comprimento da maior
+-- sequência de concursos consecutivos nos quais não foi sorteada
+-- consulta: latencia_maxima
+SELECT max(n) FROM (
+  SELECT concurso - coalesce(lag(concurso) OVER (ORDER BY concurso), 0) - 1 AS n
+    FROM dezenas_juntadas WHERE bitstatus(dezenas, ?1-1)
+  UNION ALL
+  SELECT (SELECT max(concurso) FROM concursos) - max(concurso)
+    FROM dezenas_juntadas WHERE bitstatus(dezenas, ?1-1)
+);
+
+-- máximas latências de todas as dezenas, uma dezena por registro, tal qual
+-- "latencia_maxima" numa única consulta, cujas sequências são calculadas por
+-- dezena via partições da função de janela
+-- consulta: latencias_maximas
+SELECT zeropad(dezena,2), max(n) FROM (
+  SELECT dezena, concurso - coalesce(lag(concurso) OVER (PARTITION BY dezena ORDER BY concurso), 0) - 1 AS n
+    FROM dezenas_sorteadas
+  UNION ALL
+  SELECT dezena, (SELECT max(concurso) FROM concursos) - max(concurso)
+    FROM dezenas_sorteadas GROUP BY dezena
+) GROUP BY dezena ORDER BY dezena;
+
+-- dezenas com frequência abaixo do esperado e latência acima do esperado, em
+-- ordem decrescente do ifrap, conforme "sql/rarely.sql"
+-- consulta: sugestao
+SELECT
+  zeropad(dezena,2) AS decena,
+  frequencia,
+  latencia,
+  (latencia + M / 2.0) * 100 / frequencia / frequencia AS ifrap
+FROM
+  (SELECT MAX(concurso) * 6 / 60.0 AS E FROM concursos),
+  (SELECT 60 / 6 AS L),
+  (SELECT MAX(latencia) AS M FROM info_dezenas),
+  info_dezenas
+WHERE (frequencia < E) AND (latencia >= L)
+ORDER BY ifrap DESC;
+
+-- concursos com ao menos ?2 dezenas em comum com as dezenas informadas como
+-- lista separada por espaços ou vírgulas, e as quantidades em comum
+-- consulta: semelhantes
+SELECT concurso, comuns FROM semelhantes(CAST(?1 AS TEXT), ?2) ORDER BY comuns DESC, concurso;
+
+-- frequências das combinações de duas dezenas que ocorreram ao longo do tempo,
+-- agrupadas por frequência, tal qual "scripts/duplas.sh", cujas combinações
+-- são as duplas das dezenas sorteadas em cada concurso em vez das combinações
+-- geradas por "scripts/60itens2a2.sh"
+-- consulta: frequencias_duplas
+WITH frequencias AS (
+  SELECT '{ ' || zeropad(a.dezena,2) || ' ' || zeropad(b.dezena,2) || ' }' AS par,
+    count(*) AS frequencia
+  FROM dezenas_sorteadas AS a
+    JOIN dezenas_sorteadas AS b ON b.concurso == a.concurso AND b.dezena > a.dezena
+  GROUP BY (1 << (a.dezena-1)) | (1 << (b.dezena-1))
+  ORDER BY (1 << (a.dezena-1)) | (1 << (b.dezena-1)))
+SELECT count(par) || ' duplas distintas ocorreram', frequencia || ' vezes ==>', group_concat(par, '-')
+FROM frequencias
+GROUP BY frequencia;
+
+-- frequências das combinações de três dezenas que ocorreram ao longo do tempo,
+-- agrupadas por frequência, tal qual "scripts/ternos.sh"
+-- consulta: frequencias_ternos
+WITH frequencias AS (
+  SELECT count(*) AS frequencia
+  FROM dezenas_sorteadas AS a
+    JOIN dezenas_sorteadas AS b ON b.concurso == a.concurso AND b.dezena > a.dezena
+    JOIN dezenas_sorteadas AS c ON c.concurso == a.concurso AND c.dezena > b.dezena
+  GROUP BY a.dezena, b.dezena, c.dezena)
+SELECT count(*) || ' ternos distintos ocorreram', frequencia || ' vezes.'
+FROM frequencias
+GROUP BY frequencia;
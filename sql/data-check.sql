@@ -0,0 +1,43 @@
+-- Compara o conteúdo do db com os dados extraídos do xml via checksums das
+-- tabelas "concursos" e "ganhadores", calculados pela função agregada MD5_AGG
+-- da extensão "crypt" sobre os registros em ordem de "concurso", resultando
+-- 1 se são iguais, senão 0.
+--
+-- Os registros de "concursos" no xml são lidos do buffer montado via XSLT, e
+-- os registros de "ganhadores" via GANHADORES_XML do xml informado como o
+-- parâmetro @xml. O db deve estar anexado a uma conexão em memória, evitando
+-- que a carga da extensão "crypt" modifique seu esquema:
+--
+--    sqlite3 -init ./sqlite/onload -cmd ".load ./sqlite/crypt.so" \
+--      -cmd "ATTACH 'megasena.sqlite' AS db" \
+--      -cmd ".parameter set @xml MEGA.XML" :memory: ".read sql/data-check.sql"
+--
+DROP TABLE IF EXISTS temp.buffer;
+CREATE TEMP TABLE buffer AS SELECT concurso, data_sorteio, dezena1, dezena2,
+  dezena3, dezena4, dezena5, dezena6, arrecadacao_total, ganhadores_sena,
+  cidade, uf, rateio_sena, ganhadores_quina, rateio_quina, ganhadores_quadra,
+  rateio_quadra, acumulado, valor_acumulado, estimativa_premio,
+  acumulada_mega_virada FROM concursos LIMIT 0;
+.separator '|'
+.import '/tmp/buffer.dat' buffer
+SELECT
+  (SELECT MD5_AGG(json_array(concurso, data_sorteio, dezena1, dezena2,
+     dezena3, dezena4, dezena5, dezena6, arrecadacao_total, ganhadores_sena,
+     cidade, uf, rateio_sena, ganhadores_quina, rateio_quina,
+     ganhadores_quadra, rateio_quadra, acumulado, valor_acumulado,
+     estimativa_premio, acumulada_mega_virada))
+   FROM (SELECT * FROM concursos ORDER BY concurso))
+  IS
+  (SELECT MD5_AGG(json_array(concurso, data_sorteio, dezena1, dezena2,
+     dezena3, dezena4, dezena5, dezena6, arrecadacao_total, ganhadores_sena,
+     NULLIF(cidade, 'NULL'), NULLIF(uf, 'NULL'), rateio_sena,
+     ganhadores_quina, rateio_quina, ganhadores_quadra, rateio_quadra,
+     acumulado, valor_acumulado, estimativa_premio, acumulada_mega_virada))
+   FROM (SELECT * FROM buffer ORDER BY concurso))
+  AND
+  (SELECT MD5_AGG(json_array(concurso, cidade, uf))
+   FROM (SELECT * FROM ganhadores ORDER BY concurso, rowid))
+  IS
+  (SELECT MD5_AGG(json_array(concurso, NULLIF(cidade, ''), NULLIF(uf, '')))
+   FROM ganhadores_xml(@xml));
+DROP TABLE buffer;
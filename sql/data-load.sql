@@ -1,6 +1,67 @@
--- Importa dados do buffer de registros plain/text
+-- Sincroniza incrementalmente o db com os buffers de registros plain/text de
+-- todos os concursos e ganhadores extraídos do xml, comparando o digest de
+-- cada concurso no xml com o registrado na coluna "digest" do db, tal que
+-- somente os concursos revisados são eliminados e reinseridos, além dos
+-- concursos novos. Resulta a quantidade de concursos revisados e a quantidade
+-- de ganhadores inseridos.
+--
+-- A execução é interrompida na primeira falha, cuja transação pendente é então
+-- descartada no fechamento da conexão, tal que nunca é efetivada parcialmente
+-- e.g.; com os concursos revisados eliminados mas não reinseridos.
+.bail on
 PRAGMA foreign_keys = ON;
+.load './sqlite/concursos.so'
+BEGIN TRANSACTION;
+-- tabela de passagem com as colunas importáveis de "concursos", evitando que
+-- as colunas "digest" e gerada "dia" sejam consideradas na importação
+DROP TABLE IF EXISTS temp.buffer;
+CREATE TEMP TABLE buffer AS SELECT concurso, data_sorteio, dezena1, dezena2,
+  dezena3, dezena4, dezena5, dezena6, arrecadacao_total, ganhadores_sena,
+  cidade, uf, rateio_sena, ganhadores_quina, rateio_quina, ganhadores_quadra,
+  rateio_quadra, acumulado, valor_acumulado, estimativa_premio,
+  acumulada_mega_virada FROM concursos LIMIT 0;
+DROP TABLE IF EXISTS temp.buffer_ganhadores;
+CREATE TEMP TABLE buffer_ganhadores (concurso INTEGER, cidade TEXT, uf TEXT);
 .separator '|'
-.import '/tmp/buffer.dat' concursos
-UPDATE concursos SET cidade=NULL WHERE cidade IS 'NULL';
-UPDATE concursos SET uf=NULL WHERE uf IS 'NULL';
+.import '/tmp/buffer.dat' buffer
+.import '/tmp/ganhadores.dat' buffer_ganhadores
+-- digests dos concursos no xml, incluindo o digest da lista de ganhadores
+DROP TABLE IF EXISTS temp.digests;
+CREATE TEMP TABLE digests (concurso INTEGER PRIMARY KEY, digest INTEGER);
+INSERT INTO digests SELECT concurso, DIGEST(concurso, data_sorteio, dezena1,
+  dezena2, dezena3, dezena4, dezena5, dezena6, arrecadacao_total,
+  ganhadores_sena, NULLIF(cidade, 'NULL'), NULLIF(uf, 'NULL'), rateio_sena,
+  ganhadores_quina, rateio_quina, ganhadores_quadra, rateio_quadra,
+  acumulado, valor_acumulado, estimativa_premio, acumulada_mega_virada, g)
+  FROM buffer LEFT JOIN (SELECT concurso, DIGEST_AGG(NULLIF(cidade, ''),
+  NULLIF(uf, '')) AS g FROM buffer_ganhadores GROUP BY concurso)
+  USING (concurso);
+-- elimina os concursos cujos digests diferem, inclusive os registrados antes
+-- da existência da coluna "digest", junto com seus registros dependentes
+DROP TABLE IF EXISTS temp.revisados;
+CREATE TEMP TABLE revisados AS SELECT concurso FROM concursos
+  JOIN digests USING (concurso) WHERE concursos.digest IS NOT digests.digest;
+DELETE FROM concursos WHERE concurso IN (SELECT concurso FROM revisados);
+-- insere os concursos revisados e os novos em ordem crescente
+INSERT INTO concursos (concurso, data_sorteio, dezena1, dezena2, dezena3,
+  dezena4, dezena5, dezena6, arrecadacao_total, ganhadores_sena, cidade, uf,
+  rateio_sena, ganhadores_quina, rateio_quina, ganhadores_quadra,
+  rateio_quadra, acumulado, valor_acumulado, estimativa_premio,
+  acumulada_mega_virada, digest)
+SELECT concurso, data_sorteio, dezena1, dezena2, dezena3, dezena4, dezena5,
+  dezena6, arrecadacao_total, ganhadores_sena, NULLIF(cidade, 'NULL'),
+  NULLIF(uf, 'NULL'), rateio_sena, ganhadores_quina, rateio_quina,
+  ganhadores_quadra, rateio_quadra, acumulado, valor_acumulado,
+  estimativa_premio, acumulada_mega_virada, digest
+  FROM buffer JOIN digests USING (concurso)
+  WHERE concurso NOT IN (SELECT concurso FROM concursos)
+  ORDER BY concurso;
+-- insere os ganhadores dos concursos que ainda não têm ganhadores registrados
+CREATE INDEX IF NOT EXISTS ganhadores_concurso ON ganhadores (concurso COLLATE binary);
+SELECT (SELECT COUNT(*) FROM revisados),
+  IMPORTA_GANHADORES('/tmp/ganhadores.dat', '|');
+COMMIT;
+DROP TABLE buffer;
+DROP TABLE buffer_ganhadores;
+DROP TABLE digests;
+DROP TABLE revisados;
@@ -1,6 +1,5 @@
 -- Cria ou recria todas as tabelas, views, índices e triggers.
 BEGIN TRANSACTION;
-PRAGMA legacy_file_format = ON;
 DROP TABLE IF EXISTS concursos;
 CREATE TABLE concursos (
   -- tabela obtida por conversão de documento HTML que contém
@@ -26,6 +25,13 @@ CREATE TABLE concursos (
   valor_acumulado         DOUBLE,
   estimativa_premio       DOUBLE,
   acumulada_mega_virada   DOUBLE,
+  -- digest do conteúdo do concurso e da lista de seus ganhadores conforme
+  -- extraídos do xml, usado na sincronização incremental via DIGEST
+  digest                  INTEGER,
+  -- número do dia do sorteio desde 1970-01-01 para pesquisas por intervalos
+  -- de datas via índice sem análise das strings de datas
+  dia                     INTEGER GENERATED ALWAYS AS
+                            (CAST(julianday(data_sorteio) - 2440587.5 AS INTEGER)) VIRTUAL,
   CONSTRAINT dezenas_unicas CHECK(
     dezena1 NOT IN (dezena2, dezena3, dezena4, dezena5, dezena6) AND
     dezena2 NOT IN (dezena3, dezena4, dezena5, dezena6) AND
@@ -33,6 +39,7 @@ CREATE TABLE concursos (
     dezena4 NOT IN (dezena5, dezena6) AND
     dezena5 != dezena6
   ));
+CREATE INDEX concursos_dia ON concursos (dia);
 CREATE TRIGGER IF NOT EXISTS on_concursos_insert AFTER INSERT ON concursos BEGIN
   INSERT INTO dezenas_juntadas (concurso,dezenas) VALUES (new.concurso,(1 << new.dezena1-1) | (1 << new.dezena2-1) | (1 << new.dezena3-1) | (1 << new.dezena4-1) | (1 << new.dezena5-1) | (1 << new.dezena6-1));
   INSERT INTO dezenas_sorteadas (concurso,dezena) VALUES (new.concurso,new.dezena1);
@@ -89,4 +96,12 @@ CREATE TABLE ganhadores (
   concurso  INTEGER NOT NULL,
   cidade    TEXT,
   uf        TEXT,
+  -- nome da cidade sem acentuação, em minúsculas e sem "stop words" para
+  -- pesquisas e contagens por localidade via índice, preenchido conforme
+  -- NORMALIZA da extensão "concursos" por IMPORTA_GANHADORES, tal que o
+  -- esquema não depende da extensão
+  cidade_norm TEXT,
   FOREIGN KEY (concurso) REFERENCES concursos(concurso));
+CREATE INDEX ganhadores_concurso ON ganhadores (concurso COLLATE binary);
+CREATE INDEX ganhadores_localidade ON ganhadores (uf, cidade_norm);
+.read sql/calendario.sql
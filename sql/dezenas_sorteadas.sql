@@ -5,10 +5,11 @@ SELECT
   " { " || GROUP_CONCAT(ZEROPAD(dezena,2)," ") || " } ",  -- dezenas sorteadas
   CASE acumulado WHEN 1 THEN valor_acumulado END          -- valor acumulado
 FROM
-  (SELECT DATE("now","start of year") AS inicio_do_ano),  -- início do ano
+  (SELECT CAST(JULIANDAY("now","start of year") - 2440587.5 AS INTEGER)
+     AS inicio_do_ano),                                   -- dia do início do ano
   concursos NATURAL JOIN dezenas_sorteadas
 WHERE
---  data_sorteio >= inicio_do_ano
+--  dia >= inicio_do_ano
   concurso >= (select max(concurso)-20 from concursos)
 GROUP BY
   concurso;
@@ -0,0 +1,24 @@
+-- Compara os registros extraídos via GANHADORES_XML da amostra mal formada
+-- "xsl/amostra-ganhadores.xml" com a saída da transformação "xsl/ganhadores.xsl"
+-- sobre a mesma amostra, registrada em "xsl/amostra-ganhadores.dat", resultando
+-- 1 se são iguais, senão 0. A amostra contém concursos que informam menos
+-- linhas de ganhadores que suas quantidades, inclusive no fim da tabela:
+--
+--    sqlite3 -init ./sqlite/onload :memory: ".read sql/ganhadores-xml-check.sql"
+--
+-- A saída da transformação é regenerada via:
+--
+--    xsltproc --stringparam SEPARATOR '|' xsl/ganhadores.xsl \
+--      xsl/amostra-ganhadores.xml > xsl/amostra-ganhadores.dat
+--
+DROP TABLE IF EXISTS temp.esperado;
+CREATE TEMP TABLE esperado (concurso, cidade, uf);
+.separator '|'
+.import 'xsl/amostra-ganhadores.dat' esperado
+SELECT
+  (SELECT group_concat(concurso || '|' || cidade || '|' || uf, char(10))
+   FROM (SELECT * FROM esperado ORDER BY rowid))
+  IS
+  (SELECT group_concat(concurso || '|' || ifnull(cidade, '') || '|' || ifnull(uf, ''), char(10))
+   FROM ganhadores_xml('xsl/amostra-ganhadores.xml'));
+DROP TABLE esperado;
@@ -0,0 +1,12 @@
+-- quantidades de ganhadores da sena por localidade, agrupadas pelo nome
+-- normalizado da cidade via índice "ganhadores_localidade", tal que variações
+-- de grafia, caixa e acentuação são contadas como a mesma cidade, e.g.:
+-- "Santa Bárbara d'Oeste" e "SANTA BARBARA D'OESTE"
+SELECT
+  uf,
+  MIN(cidade) AS cidade,        -- uma das grafias da cidade
+  COUNT(*) AS ganhadores
+FROM ganhadores
+WHERE uf IS NOT NULL
+GROUP BY uf, cidade_norm
+ORDER BY ganhadores DESC, uf, cidade_norm;
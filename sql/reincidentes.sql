@@ -4,6 +4,8 @@
 -- (SELECT dezenas FROM dezenas_juntadas WHERE concurso == x.concurso) &
 -- (SELECT dezenas FROM dezenas_juntadas WHERE concurso == x.concurso-1);
 
+.load './sqlite/concursos.so'
+
 -- cria tabela dos números de concursos que contém dezenas reincidentes
 -- separadas por conveniência na coluna dezenas
 CREATE TEMP TABLE IF NOT EXISTS reincidentes AS
@@ -18,17 +20,16 @@ WHERE
 -- conta número de registros na tabela dezenas reincidentes
 SELECT count(concurso) FROM reincidentes;
 
--- lista dezenas reincidentes agrupadas por frequência
+-- lista dezenas reincidentes agrupadas por frequência, que são as contagens
+-- das transições de cada dezena para si mesma no concurso seguinte
 SELECT
   frequencia, '{ ' || group_concat(decena, ' ') || ' }'
 FROM (
   SELECT
-    zeropad(dezena,2) AS decena,
-    sum((dezenas >> dezena-1) & 1) AS frequencia
-  FROM (
-      SELECT DISTINCT dezena FROM dezenas_sorteadas
-    ), reincidentes
-  GROUP BY dezena  --order by frequencia
+    zeropad(origem,2) AS decena,
+    contagem AS frequencia
+  FROM transicoes(1)
+  WHERE lag == 1 AND origem == destino
 )
 GROUP BY frequencia;
 
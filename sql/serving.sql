@@ -0,0 +1,12 @@
+-- Configura o db para o modo "serving" em que leitores concorrentes (relatórios,
+-- scripts R, dashboards) nunca bloqueiam o escritor noturno nem são bloqueados
+-- por ele. O journal em WAL é persistente no arquivo do db, então basta executar
+-- este script uma vez após a criação ou reconstrução do db.
+--
+-- Os leitores devem inicializar suas conexões via "sqlite/serving", que carrega
+-- a extensão "concursos" no ponto de entrada "sqlite3_serving_init", habilitando
+-- "memory-mapped I/O" e "query_only" e pré-carregando o cache da série:
+--
+--    sqlite3 -init ./sqlite/serving megasena.sqlite
+--
+PRAGMA journal_mode = WAL;
@@ -19,7 +19,7 @@ check() {
 
 if check 'sqlite3'
 then
-  for arquivo in 'more-functions.c' 'calendar.c'; do
+  for arquivo in 'more-functions.c' 'calendar.c' 'concursos.c'; do
     echo "compilando \"$arquivo\""
     gcc $arquivo -fPIC -shared -lm -o ${arquivo%.*}.so
   done
@@ -1,8 +1,18 @@
 /*
  * Funções de calendário com granularidade temporal "dia" no SQLite:
  *
- *    CHKDATE, DATEADD, DATEPART, DATESTR, DIFFDATES, SWAPFORMAT, TIMESTAMP,
- *    TIMEZONE, TODAY, WEEKDAY
+ *    CHKDATE, DATEADD, DATEPART, DATESTR, DAYNUM, DAYSTR, DIFFDATES,
+ *    SWAPFORMAT, TIMESTAMP, TIMEZONE, TODAY, WEEKDAY
+ *
+ * e de calendário dos sorteios da Mega-Sena:
+ *
+ *    PROXIMO_SORTEIO, ULTIMO_SORTEIO
+ *
+ * As conversões entre datas e unixtimes usam aritmética de datas civis do
+ * calendário gregoriano proléptico, sem "localtime" e "mktime", e o fuso
+ * horário é resolvido uma única vez por conexão no carregamento da extensão,
+ * portanto as funções são "thread-safe", mas as que convertem unixtimes não
+ * são determinísticas entre conexões em fusos horários distintos.
  *
  * Compilação:
  *
@@ -17,16 +27,36 @@
  *    select load_extension("path_to_lib/calendar.so");
 */
 #include <sqlite3ext.h>
+#ifdef EXTENSAO_UNIFICADA
+SQLITE_EXTENSION_INIT3
+#else
 SQLITE_EXTENSION_INIT1
+#endif
 
 #if SQLITE_VERSION_NUMBER < 3007011
 #define sqlite3_stricmp(a, b) sqlite3_strnicmp((a), (b), strlen(a))
 #endif
 
+#ifndef SQLITE_DETERMINISTIC
+#define SQLITE_DETERMINISTIC 0
+#endif
+
+#ifndef SQLITE_INNOCUOUS
+#define SQLITE_INNOCUOUS 0
+#endif
+
+#ifndef SQLITE_DIRECTONLY
+#define SQLITE_DIRECTONLY 0
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#define EXT_STATS_FONTE "calendar"
+#include "ext_stats.h"
+#include "civil.h"
+
 #define IS_DIGIT(c) (((c) >= '0') && ((c) <= '9'))
 
 #define IS_SEPARATOR(c) ((c) == '-')
@@ -41,6 +71,36 @@ static const int OFFSET[2][3] = { { 6, 3, 0 } /* DD-MM-YYYY */,
 
 #define IS_LEAP_YEAR(y) (((y) % 4 == 0 && (y) % 100 != 0) || (y) % 400 == 0)
 
+/* divisão inteira com arredondamento para -infinito sendo b > 0 */
+#define FLOOR_DIV(a, b) ((a) / (b) - ((a) % (b) < 0))
+
+#define SECONDS_PER_DAY 86400
+
+typedef sqlite3_int64 i64;
+
+/* fuso horário da conexão resolvido no carregamento da extensão */
+typedef struct timezone_s
+{
+  long offset;        /* segundos a somar ao unixtime p/obter a hora local */
+  char name[16];      /* abreviatura do fuso horário */
+}
+timezone_t;
+
+/* Valor numérico da sequência de "n" dígitos decimais. */
+static int digits(const char *z, int n)
+{
+  int v = 0;
+  while (n-- > 0) v = v * 10 + *z++ - '0';
+  return v;
+}
+
+/* Número do dia local do unixtime conforme fuso horário da conexão. */
+static i64 nixtime_to_days(const i64 seconds, const timezone_t *tz)
+{
+  i64 t = seconds + tz->offset;
+  return FLOOR_DIV(t, SECONDS_PER_DAY);
+}
+
 /*
  * Validação dos componentes da data expressa na string 'date' terminada com
  * NUL, condicionada ao check-up sequencial do seu formato, conforme valor do
@@ -57,9 +117,9 @@ static int chkdate(const char *date, const int x)
       for (k = 10, ++j; j < k && IS_DIGIT(date[j]); ++j) ;
       if (j == k && date[j] == 0) {
         const char daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-        int year  = atoi(date + OFFSET[x][YEAR]);
-        int month = atoi(date + OFFSET[x][MONTH]);
-        int day   = atoi(date + OFFSET[x][DAY]);
+        int year  = digits(date + OFFSET[x][YEAR], 4);
+        int month = digits(date + OFFSET[x][MONTH], 2);
+        int day   = digits(date + OFFSET[x][DAY], 2);
         return (0 < month && month < 13)
                && (0 < day && day <= (daysInMonth[month-1]
                                       + (month == 2 && IS_LEAP_YEAR(year))));
@@ -143,15 +203,11 @@ static void datepart(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 
   if (SQLITE_INTEGER == sqlite3_value_type(argv[0])) {
     if (chk_2nd_argument(ctx, &f, argv)) {
-      time_t seconds = (time_t) sqlite3_value_int64(argv[0]);
-      struct tm *broken_time = localtime(&seconds);
-      if (YEAR == f) {
-        rz = broken_time->tm_year + 1900;
-      } else if (MONTH == f) {
-        rz = broken_time->tm_mon + 1;
-      } else {
-        rz = broken_time->tm_mday;
-      }
+      const timezone_t *tz = (const timezone_t *) sqlite3_user_data(ctx);
+      int c[3];
+      civil_from_days(nixtime_to_days(sqlite3_value_int64(argv[0]), tz),
+        c + YEAR, c + MONTH, c + DAY);
+      rz = c[f];
     } else {
       return ;
     }
@@ -169,26 +225,31 @@ static void datepart(sqlite3_context *ctx, int argc, sqlite3_value **argv)
       return ;
     }
     if (chk_2nd_argument(ctx, &f, argv) == 0) return ;
-    rz = atoi(date + OFFSET[x][f]);
+    rz = digits(date + OFFSET[x][f], f == YEAR ? 4 : 2);
   }
   sqlite3_result_int(ctx, rz);
 }
 
+/*
+ * Número de dias decorridos desde 1970-01-01 da string de data validada no
+ * formato YYYY-MM-DD ou DD-MM-YYYY, conforme número de ordem do seu formato
+ * em "enum date_formats".
+*/
+static i64 datestring_to_days(const char *date, const int x)
+{
+  return days_from_civil(digits(date + OFFSET[x][YEAR], 4),
+    digits(date + OFFSET[x][MONTH], 2), digits(date + OFFSET[x][DAY], 2));
+}
+
 /*
  * Computa o unixtime da string de data no formato YYYY-MM-DD ou DD-MM-YYYY,
- * no instante ZERO do dia, relevando a "timezone" e "daylight saving time"
- * se disponíveis no sistema operacional. O primeiro argumento é a data e o
- * segundo é o número de ordem do seu formato conforme "enum date_formats".
+ * no instante ZERO do dia no fuso horário da conexão. O primeiro argumento é
+ * a data e o segundo é o número de ordem do seu formato conforme "enum
+ * date_formats".
 */
-static time_t datestring_to_nixtime(const char *date, const int x)
+static i64 datestring_to_nixtime(const char *date, const int x, const timezone_t *tz)
 {
-  time_t curtime = time(NULL);
-  struct tm *broken_time = localtime(&curtime);
-  broken_time->tm_year = atoi(date + OFFSET[x][YEAR]) - 1900;
-  broken_time->tm_mon  = atoi(date + OFFSET[x][MONTH]) - 1;
-  broken_time->tm_mday = atoi(date + OFFSET[x][DAY]);
-  broken_time->tm_hour = broken_time->tm_min = broken_time->tm_sec = 0;
-  return mktime(broken_time);
+  return datestring_to_days(date, x) * SECONDS_PER_DAY - tz->offset;
 }
 
 /*
@@ -202,7 +263,8 @@ static void timestamp(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     char *date = (char *) sqlite3_value_text(argv[0]);
     int x = chkdate(date, YYYY_MM_DD);
     if (x || chkdate(date, DD_MM_YYYY)) {
-      sqlite3_result_int64(ctx, (long int) datestring_to_nixtime(date, x));
+      sqlite3_result_int64(ctx, datestring_to_nixtime(date, x,
+        (const timezone_t *) sqlite3_user_data(ctx)));
     } else {
       sqlite3_result_error(ctx, "argumento não contém data valida", -1);
     }
@@ -212,34 +274,42 @@ static void timestamp(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 }
 
 /*
- * Retorna string de data no formato DD-MM-YYYY ou YYYY-MM-DD, sendo o primeiro
- * argumento o seu número de segundos na era Unix, seguido de valor ZERO-UM que
- * indica o formato desejado.
+ * Monta no buffer "z" a string de data no formato DD-MM-YYYY ou YYYY-MM-DD,
+ * sendo o segundo argumento o seu número de dias desde 1970-01-01, seguido de
+ * valor ZERO-UM que indica o formato desejado.
 */
-static char *nixtime_to_datestring(const time_t seconds, const int as_isodate)
+static void days_to_datestring(char *z, const i64 days, const int as_isodate)
 {
-  struct tm *broken_time = localtime(&seconds);
-  if (as_isodate) {
-    return sqlite3_mprintf("%04d-%02d-%02d", broken_time->tm_year+1900, \
-             broken_time->tm_mon+1, broken_time->tm_mday);
-  }
-  return sqlite3_mprintf("%02d-%02d-%04d", broken_time->tm_mday, \
-           broken_time->tm_mon+1, broken_time->tm_year+1900);
+  int y, m, d, j;
+  civil_from_days(days, &y, &m, &d);
+  j = as_isodate ? 0 : 6;
+  z[j] = '0' + y / 1000;
+  z[j+1] = '0' + y / 100 % 10;
+  z[j+2] = '0' + y / 10 % 10;
+  z[j+3] = '0' + y % 10;
+  j = as_isodate ? 5 : 3;
+  z[j] = '0' + m / 10;
+  z[j+1] = '0' + m % 10;
+  j = as_isodate ? 8 : 0;
+  z[j] = '0' + d / 10;
+  z[j+1] = '0' + d % 10;
+  z[as_isodate ? 4 : 2] = z[as_isodate ? 7 : 5] = '-';
+  z[10] = 0;
 }
 
-#define TIMESTAMP_0000_01_01_00_00_BRT -62167208012L
+#define DAYS_0000_01_01 -719528L
 
-#define TIMESTAMP_9999_12_31_00_00_BRT 253402225200L
+#define DAYS_9999_12_31 2932896L
 
 /*
- * Checa a magnitude do timestamp a formatar como DD-MM-YYYY ou YYYY-MM-DD,
- * notificando a limitação natural como erro.
+ * Checa a magnitude do número de dias da data a formatar como DD-MM-YYYY ou
+ * YYYY-MM-DD, notificando a limitação natural como erro.
 */
-static int chk_timestamp(sqlite3_context *ctx, const time_t seconds)
+static int chk_days(sqlite3_context *ctx, const i64 days)
 {
-  if (seconds < TIMESTAMP_0000_01_01_00_00_BRT) {
+  if (days < DAYS_0000_01_01) {
     sqlite3_result_error(ctx, "data resultante é anterior a 01-01-0000.", -1);
-  } else if (seconds > TIMESTAMP_9999_12_31_00_00_BRT) {
+  } else if (days > DAYS_9999_12_31) {
     sqlite3_result_error(ctx, "data resultante é posterior a 31-12-9999.", -1);
   } else {
     return 1;
@@ -255,8 +325,68 @@ static int chk_timestamp(sqlite3_context *ctx, const time_t seconds)
 */
 static void datestr(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  time_t seconds;
-  char *date;
+  i64 days;
+  char date[11];
+  int as_isodate = YYYY_MM_DD;
+
+  if (argc < 1 || argc > 2) {
+    sqlite3_result_error(ctx, "número de argumentos incorreto." \
+      "\nEsta função requer ao menos um e no máximo dois argumentos.", -1);
+    return ;
+  }
+  if (SQLITE_INTEGER != sqlite3_value_type(argv[0])) {
+    sqlite3_result_error(ctx, "primeiro argumento não é do tipo inteiro", -1);
+    return ;
+  }
+  if (argc == 2) {
+    if (SQLITE_INTEGER != sqlite3_value_type(argv[1])) {
+      sqlite3_result_error(ctx, "segundo argumento não é do tipo inteiro", -1);
+      return ;
+    }
+    as_isodate = (sqlite3_value_int(argv[1]) > 0) ? DD_MM_YYYY : YYYY_MM_DD;
+  }
+  days = nixtime_to_days(sqlite3_value_int64(argv[0]),
+    (const timezone_t *) sqlite3_user_data(ctx));
+  if (chk_days(ctx, days)) {
+    days_to_datestring(date, days, as_isodate);
+    sqlite3_result_text(ctx, date, 10, SQLITE_TRANSIENT);
+  }
+}
+
+/*
+ * Retorna o número de dias decorridos desde 1970-01-01 da data expressa com seu
+ * número inteiro de segundos decorridos na era Unix ou representada como string
+ * no formato YYYY-MM-DD ou DD-MM-YYYY, que é a representação da data usada na
+ * coluna "dia" da tabela "concursos".
+*/
+static void daynum(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  if (SQLITE_INTEGER == sqlite3_value_type(argv[0])) {
+    sqlite3_result_int64(ctx, nixtime_to_days(sqlite3_value_int64(argv[0]),
+      (const timezone_t *) sqlite3_user_data(ctx)));
+  } else if (SQLITE3_TEXT == sqlite3_value_type(argv[0])) {
+    char *date = (char *) sqlite3_value_text(argv[0]);
+    int x = chkdate(date, YYYY_MM_DD);
+    if (x || chkdate(date, DD_MM_YYYY)) {
+      sqlite3_result_int64(ctx, datestring_to_days(date, x));
+    } else {
+      sqlite3_result_error(ctx, "argumento não contém data valida", -1);
+    }
+  } else {
+    sqlite3_result_error(ctx, "argumento não é do tipo inteiro ou text", -1);
+  }
+}
+
+/*
+ * Retorna string representando data cujo número de dias decorridos desde
+ * 1970-01-01 é o valor do primeiro argumento e seu formato, conforme valor do
+ * segundo argumento opcional tal que; se for um número inteiro maior que "0",
+ * então terá formato DD-MM-YYYY, senão terá o formato default YYYY-MM-DD.
+*/
+static void daystr(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  char date[11];
+  i64 days;
   int as_isodate = YYYY_MM_DD;
 
   if (argc < 1 || argc > 2) {
@@ -275,10 +405,10 @@ static void datestr(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     }
     as_isodate = (sqlite3_value_int(argv[1]) > 0) ? DD_MM_YYYY : YYYY_MM_DD;
   }
-  seconds = (time_t) sqlite3_value_int64(argv[0]);
-  if (chk_timestamp(ctx, seconds)) {
-    date = nixtime_to_datestring(seconds, as_isodate);
-    sqlite3_result_text(ctx, date, -1, sqlite3_free);
+  days = sqlite3_value_int64(argv[0]);
+  if (chk_days(ctx, days)) {
+    days_to_datestring(date, days, as_isodate);
+    sqlite3_result_text(ctx, date, 10, SQLITE_TRANSIENT);
   }
 }
 
@@ -287,18 +417,21 @@ static void datestr(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 #define SWAP(a, b) WORD(a) ^= WORD(b), WORD(b) ^= WORD(a), WORD(a) ^= WORD(b)
 
 /*
- * Alterna o formato de data representada como string.
+ * Alterna o formato de data representada como string, operando sobre cópia
+ * do argumento cujo buffer não deve ser modificado.
 */
 static void swapformat(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *date;
+  char date[11];
   int j;
 
-  if (SQLITE3_TEXT != sqlite3_value_type(argv[0])) {
-    sqlite3_result_error(ctx, "argumento não é do tipo text", -1);
+  if (SQLITE3_TEXT != sqlite3_value_type(argv[0])
+      || sqlite3_value_bytes(argv[0]) != 10) {
+    sqlite3_result_error(ctx, (SQLITE3_TEXT != sqlite3_value_type(argv[0]))
+      ? "argumento não é do tipo text" : "argumento não contém data valida", -1);
     return ;
   }
-  date = (char *) sqlite3_value_text(argv[0]);
+  memcpy(date, sqlite3_value_text(argv[0]), sizeof(date));
   if (chkdate(date, YYYY_MM_DD)) {
     SWAP(date, date+8);
     for (j = 4; j <= 8; j += 2) SWAP(date+j, date+j-2);
@@ -309,7 +442,7 @@ static void swapformat(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     sqlite3_result_error(ctx, "argumento não contém data valida", -1);
     return ;
   }
-  sqlite3_result_text(ctx, date, -1, SQLITE_TRANSIENT);
+  sqlite3_result_text(ctx, date, 10, SQLITE_TRANSIENT);
 }
 
 /*
@@ -320,7 +453,8 @@ static void swapformat(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 static void days_between_dates(ctx, argc, argv)
   sqlite3_context *ctx; int argc; sqlite3_value **argv;
 {
-  time_t seconds[2];
+  const timezone_t *tz = (const timezone_t *) sqlite3_user_data(ctx);
+  i64 seconds[2];
   char *date;
   int j, x;
 
@@ -329,7 +463,7 @@ static void days_between_dates(ctx, argc, argv)
       date = (char *) sqlite3_value_text(argv[j]);
       x = chkdate(date, YYYY_MM_DD);
       if (x || chkdate(date, DD_MM_YYYY)) {
-        seconds[j] = datestring_to_nixtime(date, x);
+        seconds[j] = datestring_to_nixtime(date, x, tz);
       } else {
         char *z = sqlite3_mprintf("argumento #%d nao contém data valida", j+1);
         sqlite3_result_error(ctx, z, -1);
@@ -337,14 +471,17 @@ static void days_between_dates(ctx, argc, argv)
         return ;
       }
     } else if (SQLITE_INTEGER == sqlite3_value_type(argv[j])) {
-      seconds[j] = (time_t) sqlite3_value_int64(argv[j]);
+      seconds[j] = sqlite3_value_int64(argv[j]);
+    } else {
+      char *z = sqlite3_mprintf("argumento #%d não é do tipo inteiro ou text", j+1);
+      sqlite3_result_error(ctx, z, -1);
+      sqlite3_free(z);
+      return ;
     }
   }
-  sqlite3_result_int(ctx, difftime(seconds[1], seconds[0]) / 86400);
+  sqlite3_result_int(ctx, (int) ((seconds[1] - seconds[0]) / SECONDS_PER_DAY));
 }
 
-#define TERM(y, d) (int) ((y - 1.0) / d)
-
 /*
  * Retorna o nome abreviado do dia da semana de data expressa com seu número
  * inteiro de segundos decorridos na era Unix ou representada como string no
@@ -353,28 +490,29 @@ static void days_between_dates(ctx, argc, argv)
 static void weekday(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
   const char *WEEKDAY[7] = { "Dom", "Seg", "Ter", "Qua", "Qui", "Sex", "Sáb" };
+  i64 days;
   int wday;
 
   if (SQLITE_INTEGER == sqlite3_value_type(argv[0])) {
-    time_t seconds = (time_t) sqlite3_value_int64(argv[0]);
-    struct tm *broken_time = localtime(&seconds);
-    wday = broken_time->tm_wday;
+    days = nixtime_to_days(sqlite3_value_int64(argv[0]),
+      (const timezone_t *) sqlite3_user_data(ctx));
   } else if (SQLITE3_TEXT == sqlite3_value_type(argv[0])) {
     char *date = (char *) sqlite3_value_text(argv[0]);
     int x = chkdate(date, YYYY_MM_DD);
     if (x || chkdate(date, DD_MM_YYYY)) {
-      const int ndays[] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
-      int y = atoi(date + OFFSET[x][YEAR]);
-      int m = atoi(date + OFFSET[x][MONTH]);
-      int d = atoi(date + OFFSET[x][DAY]);
-      int n = d - 1 + ndays[m-1] + (m > 2 && IS_LEAP_YEAR(y));
-      wday = (y + TERM(y, 4) - TERM(y, 100) + TERM(y, 400) + n) % 7;
+      days = datestring_to_days(date, x);
     } else {
       sqlite3_result_error(ctx, "argumento não contém data valida", -1);
       return ;
     }
+  } else {
+    sqlite3_result_error(ctx, "argumento não é do tipo inteiro ou text", -1);
+    return ;
   }
-  sqlite3_result_text(ctx, WEEKDAY[wday], -1, SQLITE_TRANSIENT);
+  /* 1970-01-01 foi quinta-feira */
+  wday = (int) ((days + 4) % 7);
+  if (wday < 0) wday += 7;
+  sqlite3_result_text(ctx, WEEKDAY[wday], -1, SQLITE_STATIC);
 }
 
 /*
@@ -384,8 +522,7 @@ static void weekday(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 */
 static void today(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *date;
-  time_t seconds;
+  char date[11];
   int as_isodate = YYYY_MM_DD;
 
   if (argc > 1) {
@@ -401,9 +538,9 @@ static void today(sqlite3_context *ctx, int argc, sqlite3_value **argv)
       return ;
     }
   }
-  seconds = time(NULL);
-  date = nixtime_to_datestring(seconds, as_isodate);
-  sqlite3_result_text(ctx, date, -1, sqlite3_free);
+  days_to_datestring(date, nixtime_to_days((i64) time(NULL),
+    (const timezone_t *) sqlite3_user_data(ctx)), as_isodate);
+  sqlite3_result_text(ctx, date, 10, SQLITE_TRANSIENT);
 }
 
 /*
@@ -413,12 +550,13 @@ static void today(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 */
 static void dateadd(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *date;
-  long int seconds;
-  int ndays, x = YYYY_MM_DD;
+  char *date, z[11];
+  i64 days;
+  int x = YYYY_MM_DD;
 
   if (SQLITE_INTEGER == sqlite3_value_type(argv[0])) {
-    seconds = sqlite3_value_int64(argv[0]);
+    days = nixtime_to_days(sqlite3_value_int64(argv[0]),
+      (const timezone_t *) sqlite3_user_data(ctx));
   } else {
     if (SQLITE3_TEXT != sqlite3_value_type(argv[0])) {
       sqlite3_result_error(ctx, "primeiro argumento não é do tipo text", -1);
@@ -430,52 +568,225 @@ static void dateadd(sqlite3_context *ctx, int argc, sqlite3_value **argv)
       sqlite3_result_error(ctx, "primeiro argumento não contém data valida", -1);
       return ;
     }
-    seconds = (long int) datestring_to_nixtime(date, x);
+    days = datestring_to_days(date, x);
   }
   if (SQLITE_INTEGER != sqlite3_value_type(argv[1])) {
     sqlite3_result_error(ctx, "segundo argumento não é do tipo inteiro", -1);
     return ;
   }
-  ndays = sqlite3_value_int(argv[1]);
-  seconds += ndays * 86400L;
-  if (chk_timestamp(ctx, seconds)) {
-    date = nixtime_to_datestring((time_t) seconds, x);
-    sqlite3_result_text(ctx, date, -1, sqlite3_free);
+  days += sqlite3_value_int(argv[1]);
+  if (chk_days(ctx, days)) {
+    days_to_datestring(z, days, x);
+    sqlite3_result_text(ctx, z, 10, SQLITE_TRANSIENT);
   }
 }
 
-#define FAST_ABS(x) (((x) ^ ((x) >> 31)) - ((x) >> 31))
+/* sorteios regulares às quartas-feiras e sábados às 20:30 */
+#define DRAW_TIME (20 * 3600 + 30 * 60)
+
+#define IS_DRAW_WEEKDAY(w) ((w) == 3 || (w) == 6)
+
+/* amplitude da pesquisa de sorteios em dias e máximo de exceções nela */
+#define DRAW_SEARCH_DAYS 60
+
+#define MAX_OVERRIDES 64
+
+typedef struct draw_override_s
+{
+  i64 day;            /* número do dia desde 1970-01-01 */
+  int time;           /* segundos desde zero hora ou -1 se não há sorteio */
+}
+draw_override;
+
+/*
+ * Carrega as exceções ao calendário regular de sorteios entre os dias "from"
+ * e "to" inclusive, da tabela cujo nome é "table" que contém as colunas "data"
+ * no formato YYYY-MM-DD e "horario" no formato HH:MM, tal que "horario" NULL
+ * indica que não há sorteio na data e.g.; sorteios especiais como a "Mega da
+ * Virada" e os sorteios regulares suspensos que a antecedem.
+*/
+static int load_overrides(sqlite3 *db, const char *table, i64 from, i64 to,
+  draw_override *v, int *n)
+{
+  sqlite3_stmt *stmt;
+  char date[2][11], *z;
+  int r;
+
+  z = sqlite3_mprintf("SELECT data, horario FROM \"%w\" WHERE data BETWEEN ?1 AND ?2", table);
+  if (!z) return SQLITE_NOMEM;
+  r = sqlite3_prepare_v2(db, z, -1, &stmt, NULL);
+  sqlite3_free(z);
+  if (r != SQLITE_OK) return r;
+  days_to_datestring(date[0], from, YYYY_MM_DD);
+  days_to_datestring(date[1], to, YYYY_MM_DD);
+  sqlite3_bind_text(stmt, 1, date[0], 10, SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 2, date[1], 10, SQLITE_STATIC);
+  for (*n = 0; *n < MAX_OVERRIDES && (r = sqlite3_step(stmt)) == SQLITE_ROW; ) {
+    const char *d = (const char *) sqlite3_column_text(stmt, 0);
+    const char *h = (const char *) sqlite3_column_text(stmt, 1);
+    if (!d || !chkdate(d, YYYY_MM_DD)) continue;
+    v[*n].day = datestring_to_days(d, YYYY_MM_DD);
+    if (h && IS_DIGIT(h[0]) && IS_DIGIT(h[1]) && h[2] == ':' && IS_DIGIT(h[3]) && IS_DIGIT(h[4])) {
+      v[*n].time = digits(h, 2) * 3600 + digits(h + 3, 2) * 60;
+    } else {
+      v[*n].time = -1;
+    }
+    (*n)++;
+  }
+  sqlite3_finalize(stmt);
+  return (r == SQLITE_ROW || r == SQLITE_DONE) ? SQLITE_OK : r;
+}
+
+/*
+ * Pesquisa o sorteio mais próximo do unixtime no primeiro argumento, posterior
+ * se "forward" não é zero ou anterior/simultâneo caso contrário, conforme o
+ * calendário regular e as exceções na tabela opcionalmente nomeada no segundo
+ * argumento, retornando o unixtime do sorteio.
+*/
+static void draw_search(sqlite3_context *ctx, int argc, sqlite3_value **argv, int forward)
+{
+  const timezone_t *tz = (const timezone_t *) sqlite3_user_data(ctx);
+  draw_override v[MAX_OVERRIDES];
+  i64 t, today;
+  int j, k, n = 0;
+
+  if (argc < 1 || argc > 2) {
+    sqlite3_result_error(ctx, "número de argumentos incorreto." \
+      "\nEsta função requer ao menos um e no máximo dois argumentos.", -1);
+    return ;
+  }
+  if (SQLITE_INTEGER != sqlite3_value_type(argv[0])) {
+    sqlite3_result_error(ctx, "primeiro argumento não é do tipo inteiro", -1);
+    return ;
+  }
+  t = sqlite3_value_int64(argv[0]) + tz->offset;
+  today = FLOOR_DIV(t, SECONDS_PER_DAY);
+  if (argc == 2 && SQLITE_NULL != sqlite3_value_type(argv[1])) {
+    int r;
+    if (SQLITE3_TEXT != sqlite3_value_type(argv[1])) {
+      sqlite3_result_error(ctx, "segundo argumento não é do tipo text", -1);
+      return ;
+    }
+    r = load_overrides(sqlite3_context_db_handle(ctx),
+      (const char *) sqlite3_value_text(argv[1]),
+      forward ? today : today - DRAW_SEARCH_DAYS,
+      forward ? today + DRAW_SEARCH_DAYS : today, v, &n);
+    if (r != SQLITE_OK) {
+      char *z = sqlite3_mprintf("falha na leitura das exceções ao calendário: %s",
+        sqlite3_errmsg(sqlite3_context_db_handle(ctx)));
+      sqlite3_result_error(ctx, z, -1);
+      sqlite3_free(z);
+      return ;
+    }
+  }
+  for (k = 0; k <= DRAW_SEARCH_DAYS; ++k) {
+    i64 day = forward ? today + k : today - k;
+    int w = (int) ((day + 4) % 7), time;
+    if (w < 0) w += 7;
+    time = IS_DRAW_WEEKDAY(w) ? DRAW_TIME : -1;
+    for (j = 0; j < n; ++j) {
+      if (v[j].day == day) time = v[j].time;
+    }
+    if (time >= 0) {
+      i64 draw = day * SECONDS_PER_DAY + time;
+      if (forward ? draw > t : draw <= t) {
+        sqlite3_result_int64(ctx, draw - tz->offset);
+        return ;
+      }
+    }
+  }
+}
+
+/*
+ * Retorna o unixtime do primeiro sorteio posterior ao unixtime no primeiro
+ * argumento, considerando as exceções na tabela opcionalmente nomeada no
+ * segundo argumento.
+*/
+static void proximo_sorteio(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  draw_search(ctx, argc, argv, 1);
+}
 
-extern long int timezone;
+/*
+ * Retorna o unixtime do sorteio mais recente até o unixtime no primeiro
+ * argumento inclusive, considerando as exceções na tabela opcionalmente
+ * nomeada no segundo argumento.
+*/
+static void ultimo_sorteio(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  draw_search(ctx, argc, argv, 0);
+}
 
-extern char *tzname[2];
+#define FAST_ABS(x) (((x) ^ ((x) >> 31)) - ((x) >> 31))
 
-/* Informa o fuso horário aka "timezone" em vigência no sistema. */
+/* Informa o fuso horário aka "timezone" em vigência na conexão. */
 static void timezone_info(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  time_t seconds = time(NULL);
-  struct tm *t = localtime(&seconds);
-  int h = FAST_ABS(timezone);
-  char *r = sqlite3_mprintf("%c%02d%02d %s", (timezone > 0 ? '-' : '+'),
-         (h / 3600 - t->tm_isdst), (h % 3600 / 60), tzname[t->tm_isdst]);
+  const timezone_t *tz = (const timezone_t *) sqlite3_user_data(ctx);
+  int h = FAST_ABS((int) tz->offset);
+  char *r = sqlite3_mprintf("%c%02d%02d %s", (tz->offset < 0 ? '-' : '+'),
+         (h / 3600), (h % 3600 / 60), tz->name);
   sqlite3_result_text(ctx, r, -1, sqlite3_free);
 }
 
-int sqlite3_extension_init(db, err, api)
+/*
+ * Resolve o fuso horário em vigência no sistema no instante do carregamento da
+ * extensão, que é a única consulta ao estado "TZ" do sistema, comparando as
+ * decomposições do instante corrente em hora local e em UTC.
+*/
+static void resolve_timezone(timezone_t *tz)
+{
+  time_t now = time(NULL);
+  struct tm local, utc;
+  localtime_r(&now, &local);
+  gmtime_r(&now, &utc);
+  tz->offset = (long) ((days_from_civil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday)
+    - days_from_civil(utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday)) * SECONDS_PER_DAY)
+    + (local.tm_hour - utc.tm_hour) * 3600L + (local.tm_min - utc.tm_min) * 60L
+    + (local.tm_sec - utc.tm_sec);
+  if (strftime(tz->name, sizeof(tz->name), "%Z", &local) == 0) *tz->name = 0;
+}
+
+#define PURE (SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS)
+
+/*
+ * Funções cujos resultados para unixtimes dependem do fuso horário resolvido
+ * na carga da extensão, portanto não são declaradas determinísticas e não
+ * podem ser usadas em índices, colunas geradas e restrições CHECK, que
+ * divergiriam entre processos em fusos horários distintos.
+*/
+#define FUSO (SQLITE_UTF8 | SQLITE_INNOCUOUS)
+
+int sqlite3_calendar_init(db, err, api)
   sqlite3 *db; char **err; const sqlite3_api_routines *api;
 {
-  SQLITE_EXTENSION_INIT2(api)
+  timezone_t *tz;
 
-  sqlite3_create_function(db, "CHKDATE", -1, SQLITE_UTF8, NULL, chkdateFunc, NULL, NULL);
-  sqlite3_create_function(db, "DATEPART", 2, SQLITE_UTF8, NULL, datepart, NULL, NULL);
-  sqlite3_create_function(db, "TIMESTAMP", 1, SQLITE_UTF8, NULL, timestamp, NULL, NULL);
-  sqlite3_create_function(db, "DATESTR", -1, SQLITE_UTF8, NULL, datestr, NULL, NULL);
-  sqlite3_create_function(db, "SWAPFORMAT", 1, SQLITE_UTF8, NULL, swapformat, NULL, NULL);
-  sqlite3_create_function(db, "DIFFDATES", 2, SQLITE_UTF8, NULL, days_between_dates, NULL, NULL);
-  sqlite3_create_function(db, "WEEKDAY", 1, SQLITE_UTF8, NULL, weekday, NULL, NULL);
-  sqlite3_create_function(db, "TODAY", -1, SQLITE_UTF8, NULL, today, NULL, NULL);
-  sqlite3_create_function(db, "DATEADD", 2, SQLITE_UTF8, NULL, dateadd, NULL, NULL);
-  sqlite3_create_function(db, "TIMEZONE", 0, SQLITE_UTF8, NULL, timezone_info, NULL, NULL);
+  SQLITE_EXTENSION_INIT2(api)
+  EXT_STATS_REGISTRA(db);
+
+  tz = (timezone_t *) sqlite3_malloc(sizeof(timezone_t));
+  if (!tz) return SQLITE_NOMEM;
+  resolve_timezone(tz);
+
+  /* o fuso horário é liberado quando a conexão é fechada */
+  sqlite3_create_function_v2(db, "TIMEZONE", 0, SQLITE_UTF8, tz, timezone_info, NULL, NULL, sqlite3_free);
+  sqlite3_create_function(db, "TODAY", -1, SQLITE_UTF8, tz, today, NULL, NULL);
+
+  sqlite3_create_function(db, "CHKDATE", -1, PURE, NULL, chkdateFunc, NULL, NULL);
+  sqlite3_create_function(db, "DATEPART", 2, FUSO, tz, datepart, NULL, NULL);
+  sqlite3_create_function(db, "TIMESTAMP", 1, FUSO, tz, timestamp, NULL, NULL);
+  sqlite3_create_function(db, "DATESTR", -1, FUSO, tz, datestr, NULL, NULL);
+  sqlite3_create_function(db, "DAYNUM", 1, FUSO, tz, daynum, NULL, NULL);
+  sqlite3_create_function(db, "DAYSTR", -1, PURE, NULL, daystr, NULL, NULL);
+  sqlite3_create_function(db, "SWAPFORMAT", 1, PURE, NULL, swapformat, NULL, NULL);
+  sqlite3_create_function(db, "DIFFDATES", 2, FUSO, tz, days_between_dates, NULL, NULL);
+  sqlite3_create_function(db, "WEEKDAY", 1, FUSO, tz, weekday, NULL, NULL);
+  sqlite3_create_function(db, "DATEADD", 2, FUSO, tz, dateadd, NULL, NULL);
+
+  /* consultam a tabela de exceções ao calendário cujo nome é argumento */
+  sqlite3_create_function(db, "PROXIMO_SORTEIO", -1, SQLITE_UTF8 | SQLITE_DIRECTONLY, tz, proximo_sorteio, NULL, NULL);
+  sqlite3_create_function(db, "ULTIMO_SORTEIO", -1, SQLITE_UTF8 | SQLITE_DIRECTONLY, tz, ultimo_sorteio, NULL, NULL);
 
   return 0;
 }
@@ -0,0 +1,42 @@
+/*
+ * Aritmética de datas civis do calendário gregoriano proléptico compartilhada
+ * pelas extensões "calendar" e "concursos", que converte datas em números de
+ * dias decorridos desde 1970-01-01 e vice-versa, conforme os algoritmos
+ * "days_from_civil" e "civil_from_days" de Howard Hinnant, sem "localtime" e
+ * "mktime", portanto "thread-safe" e independente do fuso horário.
+ *
+ * Deve ser incluído após "sqlite3ext.h".
+*/
+#ifndef CIVIL_H
+#define CIVIL_H
+
+/* Número de dias decorridos desde 1970-01-01 da data civil. */
+static sqlite3_int64 days_from_civil(int y, int m, int d)
+{
+  sqlite3_int64 era;
+  unsigned yoe, doy, doe;
+  y -= m <= 2;
+  era = (y >= 0 ? y : y - 399) / 400;
+  yoe = (unsigned) (y - era * 400);
+  doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (sqlite3_int64) doe - 719468;
+}
+
+/* Inverso de "days_from_civil". */
+static void civil_from_days(sqlite3_int64 z, int *y, int *m, int *d)
+{
+  sqlite3_int64 era;
+  unsigned doe, yoe, doy, mp;
+  z += 719468;
+  era = (z >= 0 ? z : z - 146096) / 146097;
+  doe = (unsigned) (z - era * 146097);
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = (int) (yoe + era * 400) + (*m <= 2);
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Cliente do servidor local de consultas ao db da Mega-Sena (ver servidor.c),
+ * que requisita a consulta nomeada com os argumentos informados, escrevendo
+ * os registros da resposta com os campos separados por " " tal qual os
+ * scripts que usam "sqlite/onload", ou pelo separador informado.
+ *
+ * Compilação:
+ *
+ *    gcc cliente.c -Wall -O2 -o cliente
+ *
+ * Uso:
+ *
+ *    ./sqlite/cliente [-s socket] [-d separador] consulta [argumentos...]
+ *
+ * O status de saída é 0 se a consulta foi executada, 1 se o servidor
+ * respondeu com erro e 2 se o servidor não está disponível.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SOCKET_PADRAO "/tmp/megasena.sock"
+#define US '\x1F'
+
+int main(int argc, char *argv[])
+{
+  const char *endereco = SOCKET_PADRAO, *separador = " ";
+  struct sockaddr_un sa;
+  char buf[8192];
+  FILE *io;
+  int opt, s, j, n, ch, status;
+
+  while ((opt = getopt(argc, argv, "s:d:")) != -1) {
+    switch (opt) {
+      case 's': endereco = optarg; break;
+      case 'd': separador = optarg; break;
+      default: optind = argc; break;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "uso: %s [-s socket] [-d separador] consulta [argumentos...]\n", argv[0]);
+    return 2;
+  }
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  strncpy(sa.sun_path, endereco, sizeof(sa.sun_path) - 1);
+  if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+      || connect(s, (struct sockaddr *) &sa, sizeof(sa)) < 0) {
+    fprintf(stderr, "cliente: servidor não está disponível: %s\n", strerror(errno));
+    return 2;
+  }
+
+  /* requisição: nome da consulta e argumentos separados por TAB */
+  for (j = optind, n = 0; j < argc && n < sizeof(buf); ++j) {
+    n += snprintf(buf + n, sizeof(buf) - n, "%s%s", j > optind ? "\t" : "", argv[j]);
+  }
+  if (n >= sizeof(buf) - 1) {
+    fputs("cliente: requisição é longa demais\n", stderr);
+    return 2;
+  }
+  buf[n++] = '\n';
+  if (write(s, buf, n) != n) {
+    fprintf(stderr, "cliente: falha no envio da requisição: %s\n", strerror(errno));
+    return 2;
+  }
+  shutdown(s, SHUT_WR);
+
+  io = fdopen(s, "r");
+  status = fgetc(io);
+  if (status == '+') {
+    while ((ch = fgetc(io)) != EOF) {
+      if (ch == US) fputs(separador, stdout); else putchar(ch);
+    }
+  } else {
+    fputs("cliente: ", stderr);
+    while ((n = fread(buf, 1, sizeof(buf), io)) > 0) fwrite(buf, 1, n, stderr);
+  }
+  fclose(io);
+  return status == '+' ? 0 : 1;
+}
@@ -0,0 +1,3356 @@
+/*
+ * Série temporal dos concursos da Mega-Sena no SQLite, mantida num cache
+ * empacotado por conexão que contém as máscaras das dezenas sorteadas, as
+ * datas dos sorteios e os status de acumulação dos concursos:
+ *
+ *    MASCARA, EXPORTA_SERIE, IMPORTA_GANHADORES, DIGEST, NORMALIZA, REGIAO,
+ *    ASSINATURA
+ *
+ * Função agregada:
+ *
+ *    DIGEST_AGG, RENDER_BOLETO
+ *
+ * Funções "table-valued" i.e.; tabelas virtuais com argumentos:
+ *
+ *    JANELA, EVOLUCAO, GANHADORES_XML, SORTEIOS_ENTRE, RUNS,
+ *    DISTRIBUICAO_ESPACIAL, TRANSICOES, SEMELHANTES
+ *
+ * Tabela virtual "eponymous":
+ *
+ *    TESTES
+ *
+ * O cache é carregado sob demanda e recarregado somente se o conteúdo do db
+ * foi modificado por esta ou outra conexão, conforme "PRAGMA data_version" e
+ * o número total de modificações efetuadas pela conexão.
+ *
+ * Compilação:
+ *
+ *    gcc concursos.c -Wall -fPIC -shared -lm -o concursos.so
+ *
+ * Uso em arquivos de inicialização ou sessões interativas:
+ *
+ *    .load "path_to_lib/concursos.so"
+ *
+ * ou como requisição SQLite:
+ *
+ *    select load_extension("path_to_lib/concursos.so");
+ *
+ * Modo "serving" para leitores concorrentes de db em WAL (ver sql/serving.sql)
+ * que além de registrar as funções, habilita "memory-mapped I/O", proíbe
+ * escritas pela conexão e pré-carrega o cache e as páginas do db:
+ *
+ *    .load "path_to_lib/concursos.so" "sqlite3_serving_init"
+*/
+#include <sqlite3ext.h>
+#ifdef EXTENSAO_UNIFICADA
+SQLITE_EXTENSION_INIT3
+#else
+SQLITE_EXTENSION_INIT1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#define EXT_STATS_FONTE "concursos"
+#include "ext_stats.h"
+#include "civil.h"
+
+#ifndef SQLITE_DETERMINISTIC
+#define SQLITE_DETERMINISTIC 0
+#endif
+
+#ifndef SQLITE_INNOCUOUS
+#define SQLITE_INNOCUOUS 0
+#endif
+
+#ifndef SQLITE_DIRECTONLY
+#define SQLITE_DIRECTONLY 0
+#endif
+
+typedef sqlite3_uint64 u64;
+
+#define N_DEZENAS 60 /* quantidade de números da Mega-Sena */
+
+/*
+ * Os laços de contagem de bits sobre as máscaras também são compilados com a
+ * instrução POPCNT, cuja versão é selecionada na carga da biblioteca conforme
+ * a CPU, exceto se o alvo da compilação já a inclui, e.g.; -march=native.
+*/
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__POPCNT__)
+#define KERNEL_POPCNT __attribute__((target_clones("popcnt", "default")))
+#else
+#define KERNEL_POPCNT
+#endif
+
+/* limite de bytes mapeados em memória no modo "serving" */
+#define MMAP_SIZE 268435456
+
+typedef struct serie_s
+{
+  int n;                  /* quantidade de concursos no cache */
+  int capacidade;         /* quantidade de concursos alocados */
+  int *concurso;          /* números dos concursos em ordem crescente */
+  u64 *dezenas;           /* máscaras: bit d-1 ligado se a dezena d foi sorteada */
+  int *dia;               /* datas dos sorteios em dias desde 1970-01-01 */
+  unsigned char *acumulado;
+  int carregada;          /* indica se o cache foi carregado ao menos uma vez */
+  int versao;             /* valor de "PRAGMA data_version" na carga */
+  int mudancas;           /* valor de sqlite3_total_changes() na carga */
+}
+serie_t;
+
+static void libera_serie(void *ptr)
+{
+  serie_t *s = (serie_t *) ptr;
+  sqlite3_free(s->concurso);
+  sqlite3_free(s->dezenas);
+  sqlite3_free(s->dia);
+  sqlite3_free(s->acumulado);
+  sqlite3_free(s);
+}
+
+/* Data no formato YYYY-MM-DD do número de dias desde 1970-01-01. */
+static void dia_to_data(int dia, char *z, int n)
+{
+  int y, m, d;
+  civil_from_days(dia, &y, &m, &d);
+  sqlite3_snprintf(n, z, "%04d-%02d-%02d", y, m, d);
+}
+
+#define IS_DIGIT(c) (((c) >= '0') && ((c) <= '9'))
+
+/*
+ * Converte data no formato YYYY-MM-DD em número de dias desde 1970-01-01 sem
+ * validação dos componentes, que é responsabilidade do esquema do db.
+*/
+static int data_to_dia(const unsigned char *z)
+{
+  int j, y = 0, m = 0, d = 0;
+  if (!z) return 0;
+  for (j = 0; j < 4 && IS_DIGIT(z[j]); ++j) y = y * 10 + z[j] - '0';
+  if (j < 4 || z[4] != '-') return 0;
+  for (j = 5; j < 7 && IS_DIGIT(z[j]); ++j) m = m * 10 + z[j] - '0';
+  for (j = 8; j < 10 && IS_DIGIT(z[j]); ++j) d = d * 10 + z[j] - '0';
+  return (int) days_from_civil(y, m, d);
+}
+
+static int aloca_serie(serie_t *s, int capacidade)
+{
+  void *p;
+  if ((p = sqlite3_realloc64(s->concurso, capacidade * sizeof(int))) == 0) return SQLITE_NOMEM;
+  s->concurso = (int *) p;
+  if ((p = sqlite3_realloc64(s->dezenas, capacidade * sizeof(u64))) == 0) return SQLITE_NOMEM;
+  s->dezenas = (u64 *) p;
+  if ((p = sqlite3_realloc64(s->dia, capacidade * sizeof(int))) == 0) return SQLITE_NOMEM;
+  s->dia = (int *) p;
+  if ((p = sqlite3_realloc64(s->acumulado, capacidade)) == 0) return SQLITE_NOMEM;
+  s->acumulado = (unsigned char *) p;
+  s->capacidade = capacidade;
+  return SQLITE_OK;
+}
+
+/* Retorna o valor de "PRAGMA data_version" ou -1 em caso de erro. */
+static int data_version(sqlite3 *db)
+{
+  sqlite3_stmt *stmt;
+  int v = -1;
+  if (sqlite3_prepare_v2(db, "PRAGMA data_version;", -1, &stmt, NULL) == SQLITE_OK) {
+    if (sqlite3_step(stmt) == SQLITE_ROW) v = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+  }
+  return v;
+}
+
+/*
+ * Carrega ou recarrega o cache da série se o db foi modificado desde a carga
+ * anterior, retornando SQLITE_OK ou o código de erro correspondente.
+*/
+static int carrega_serie(sqlite3 *db, serie_t *s)
+{
+  sqlite3_stmt *stmt;
+  int j, r, versao, mudancas;
+
+  versao = data_version(db);
+  mudancas = sqlite3_total_changes(db);
+  if (s->carregada && versao == s->versao && mudancas == s->mudancas) {
+    return SQLITE_OK;
+  }
+
+  r = sqlite3_prepare_v2(db, "SELECT concurso, data_sorteio, acumulado, " \
+    "dezena1, dezena2, dezena3, dezena4, dezena5, dezena6 " \
+    "FROM concursos ORDER BY concurso;", -1, &stmt, NULL);
+  if (r != SQLITE_OK) return r;
+
+  s->n = 0;
+  while ((r = sqlite3_step(stmt)) == SQLITE_ROW) {
+    u64 mask = 0;
+    if (s->n == s->capacidade) {
+      if (aloca_serie(s, s->capacidade ? s->capacidade * 2 : 2048) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        s->carregada = 0;
+        return SQLITE_NOMEM;
+      }
+    }
+    for (j = 3; j < 9; ++j) {
+      int d = sqlite3_column_int(stmt, j);
+      if (d >= 1 && d <= N_DEZENAS) mask |= ((u64) 1) << (d-1);
+    }
+    s->concurso[s->n] = sqlite3_column_int(stmt, 0);
+    s->dia[s->n] = data_to_dia(sqlite3_column_text(stmt, 1));
+    s->acumulado[s->n] = sqlite3_column_int(stmt, 2) != 0;
+    s->dezenas[s->n] = mask;
+    s->n++;
+  }
+  sqlite3_finalize(stmt);
+  if (r != SQLITE_DONE) {
+    s->carregada = 0;
+    return r;
+  }
+
+  s->versao = versao;
+  s->mudancas = mudancas;
+  s->carregada = 1;
+  return SQLITE_OK;
+}
+
+/*
+ * Pesquisa a posição do concurso no cache, retornando -1 se não existir.
+ * A série normalmente é contígua, então o acesso direto é tentado antes da
+ * pesquisa binária.
+*/
+static int posicao_concurso(const serie_t *s, int concurso)
+{
+  int lo, hi;
+  if (s->n == 0) return -1;
+  lo = concurso - s->concurso[0];
+  if (lo >= 0 && lo < s->n && s->concurso[lo] == concurso) return lo;
+  for (lo = 0, hi = s->n - 1; lo <= hi; ) {
+    int m = lo + (hi - lo) / 2;
+    if (s->concurso[m] == concurso) return m;
+    if (s->concurso[m] < concurso) lo = m + 1; else hi = m - 1;
+  }
+  return -1;
+}
+
+/*
+ * Notifica como erro da função a falha na carga do cache da série.
+*/
+static void erro_serie(sqlite3_context *ctx, int r)
+{
+  if (r == SQLITE_NOMEM) {
+    sqlite3_result_error_nomem(ctx);
+  } else {
+    char *z = sqlite3_mprintf("falha na carga da série dos concursos: %s",
+      sqlite3_errmsg(sqlite3_context_db_handle(ctx)));
+    sqlite3_result_error(ctx, z, -1);
+    sqlite3_free(z);
+  }
+}
+
+/*
+ * Retorna a máscara das dezenas sorteadas no concurso cujo número é o único
+ * argumento, equivalente a consulta à tabela "dezenas_juntadas", ou NULL se
+ * o concurso não existir.
+*/
+static void mascara(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  serie_t *s = (serie_t *) sqlite3_user_data(ctx);
+  int j, r;
+
+  if (SQLITE_INTEGER != sqlite3_value_numeric_type(argv[0])) {
+    sqlite3_result_error(ctx, "argumento não é do tipo inteiro", -1);
+    return ;
+  }
+  r = carrega_serie(sqlite3_context_db_handle(ctx), s);
+  if (r != SQLITE_OK) {
+    erro_serie(ctx, r);
+    return ;
+  }
+  j = posicao_concurso(s, sqlite3_value_int(argv[0]));
+  if (j < 0) {
+    sqlite3_result_null(ctx);
+  } else {
+    sqlite3_result_int64(ctx, (sqlite3_int64) s->dezenas[j]);
+  }
+}
+
+/*
+ * Formato "mega" do arquivo binário da série exportada, em "little endian" e
+ * mapeável em memória sem conversões por R, Python ou programas em C:
+ *
+ *    offset  tamanho  conteúdo
+ *         0        8  assinatura "MEGASENA"
+ *         8        4  versão do formato (uint32)
+ *        12        4  capacidade: quantidade de registros reservados (uint32)
+ *        16        4  quantidade de registros gravados (uint32)
+ *        20        4  reservado
+ *        24       32  offsets das colunas (uint64): dezenas, concurso, dia e
+ *                     acumulado, nessa ordem
+ *        64      8*C  máscaras das dezenas (uint64)
+ *                4*C  números dos concursos (int32)
+ *                4*C  datas dos sorteios em dias desde 1970-01-01 (int32)
+ *                  C  status de acumulação (uint8)
+ *
+ * As colunas têm espaço reservado para C registros, então a gravação dos
+ * concursos mais recentes apenas complementa as colunas e por último atualiza
+ * a quantidade de registros no cabeçalho, permitindo leitura concorrente.
+*/
+#define MEGA_ASSINATURA "MEGASENA"
+#define MEGA_VERSAO 1
+#define MEGA_CABECALHO 64
+#define MEGA_BLOCO 4096   /* granularidade da capacidade em registros */
+
+typedef struct mega_s
+{
+  char assinatura[8];
+  unsigned int versao;
+  unsigned int capacidade;
+  unsigned int n;
+  unsigned int reservado;
+  u64 offset[4];
+}
+mega_t;
+
+static void offsets_mega(mega_t *h)
+{
+  h->offset[0] = MEGA_CABECALHO;
+  h->offset[1] = h->offset[0] + (u64) h->capacidade * sizeof(u64);
+  h->offset[2] = h->offset[1] + (u64) h->capacidade * sizeof(int);
+  h->offset[3] = h->offset[2] + (u64) h->capacidade * sizeof(int);
+}
+
+/*
+ * Grava os registros do cache da série com posições no intervalo [a;b) nas
+ * respectivas colunas do arquivo, retornando zero se bem sucedida.
+*/
+static int grava_colunas(FILE *f, const mega_t *h, const serie_t *s, int a, int b)
+{
+  if (b <= a) return 0;
+  return fseek(f, h->offset[0] + (u64) a * sizeof(u64), SEEK_SET)
+    || fwrite(s->dezenas + a, sizeof(u64), b - a, f) != (size_t) (b - a)
+    || fseek(f, h->offset[1] + (u64) a * sizeof(int), SEEK_SET)
+    || fwrite(s->concurso + a, sizeof(int), b - a, f) != (size_t) (b - a)
+    || fseek(f, h->offset[2] + (u64) a * sizeof(int), SEEK_SET)
+    || fwrite(s->dia + a, sizeof(int), b - a, f) != (size_t) (b - a)
+    || fseek(f, h->offset[3] + a, SEEK_SET)
+    || fwrite(s->acumulado + a, 1, b - a, f) != (size_t) (b - a);
+}
+
+/*
+ * Testa se os "n" bytes a partir do offset do arquivo são iguais aos bytes
+ * apontados por "p", retornando zero se são iguais.
+*/
+static int compara_coluna(FILE *f, u64 offset, const void *p, size_t n)
+{
+  const char *z = (const char *) p;
+  char buffer[4096];
+  size_t k;
+
+  if (fseek(f, offset, SEEK_SET)) return -1;
+  for (; n > 0; n -= k, z += k) {
+    k = n < sizeof(buffer) ? n : sizeof(buffer);
+    if (fread(buffer, 1, k, f) != k || memcmp(buffer, z, k)) return -1;
+  }
+  return 0;
+}
+
+/*
+ * Testa se o arquivo existente é prefixo da série no cache, comparando todas
+ * as colunas dos registros gravados, pois concursos antigos podem ter sido
+ * revisados no db, retornando a quantidade de registros gravados que podem ser
+ * mantidos ou -1 se o arquivo deve ser recriado.
+*/
+static int prefixo_mega(FILE *f, mega_t *h, const serie_t *s)
+{
+  if (fread(h, sizeof(mega_t), 1, f) != 1
+      || memcmp(h->assinatura, MEGA_ASSINATURA, 8) || h->versao != MEGA_VERSAO
+      || h->n > (unsigned int) s->n || h->n > h->capacidade) return -1;
+  if (compara_coluna(f, h->offset[0], s->dezenas, (size_t) h->n * sizeof(u64))
+      || compara_coluna(f, h->offset[1], s->concurso, (size_t) h->n * sizeof(int))
+      || compara_coluna(f, h->offset[2], s->dia, (size_t) h->n * sizeof(int))
+      || compara_coluna(f, h->offset[3], s->acumulado, h->n)) return -1;
+  return h->n;
+}
+
+/*
+ * Exporta a série dos concursos para o arquivo cujo path é o primeiro argumento,
+ * no formato opcionalmente especificado pelo segundo argumento, atualmente
+ * somente "mega". Se o arquivo existe e é prefixo da série, inclusive quanto
+ * aos concursos revisados, então somente os concursos mais recentes são
+ * gravados, senão o arquivo é recriado via arquivo
+ * temporário e renomeação, preservando leitores que o mapearam em memória.
+ * Retorna a quantidade de registros gravados.
+*/
+static void exporta_serie(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  serie_t *s = (serie_t *) sqlite3_user_data(ctx);
+  const char *path;
+  char *tmp;
+  FILE *f;
+  mega_t h;
+  int k, r;
+
+  if (SQLITE3_TEXT != sqlite3_value_type(argv[0])) {
+    sqlite3_result_error(ctx, "primeiro argumento não é do tipo text", -1);
+    return ;
+  }
+  path = (const char *) sqlite3_value_text(argv[0]);
+  if (argc == 2 && SQLITE_NULL != sqlite3_value_type(argv[1])
+      && sqlite3_stricmp((const char *) sqlite3_value_text(argv[1]), "mega")) {
+    sqlite3_result_error(ctx, "formato desconhecido.\nFormatos disponíveis: mega.", -1);
+    return ;
+  }
+  r = carrega_serie(sqlite3_context_db_handle(ctx), s);
+  if (r != SQLITE_OK) {
+    erro_serie(ctx, r);
+    return ;
+  }
+
+  /* complementa o arquivo existente se possível */
+  f = fopen(path, "r+b");
+  if (f) {
+    k = prefixo_mega(f, &h, s);
+    if (k >= 0 && (unsigned int) s->n <= h.capacidade) {
+      r = grava_colunas(f, &h, s, k, s->n);
+      if (!r && k < s->n) {
+        h.n = s->n;
+        r = fseek(f, 0, SEEK_SET) || fwrite(&h, sizeof(mega_t), 1, f) != 1;
+      }
+      r = fclose(f) || r;
+      if (r) {
+        sqlite3_result_error(ctx, "falha na gravação do arquivo", -1);
+      } else {
+        sqlite3_result_int(ctx, s->n - k);
+      }
+      return ;
+    }
+    fclose(f);
+  }
+
+  /* recria o arquivo com capacidade para MEGA_BLOCO+ registros adicionais */
+  memset(&h, 0, sizeof(mega_t));
+  memcpy(h.assinatura, MEGA_ASSINATURA, 8);
+  h.versao = MEGA_VERSAO;
+  h.capacidade = (s->n / MEGA_BLOCO + 1) * MEGA_BLOCO;
+  h.n = s->n;
+  offsets_mega(&h);
+
+  tmp = sqlite3_mprintf("%s.tmp", path);
+  if (!tmp) {
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+  f = fopen(tmp, "wb");
+  if (!f) {
+    sqlite3_result_error(ctx, "falha na criação do arquivo", -1);
+    sqlite3_free(tmp);
+    return ;
+  }
+  r = fwrite(&h, sizeof(mega_t), 1, f) != 1
+    || grava_colunas(f, &h, s, 0, s->n)
+    /* estende o arquivo até o final da última coluna */
+    || fseek(f, h.offset[3] + h.capacidade - 1, SEEK_SET)
+    || fputc(0, f) == EOF;
+  r = fclose(f) || r;
+  if (r || rename(tmp, path)) {
+    remove(tmp);
+    sqlite3_result_error(ctx, "falha na gravação do arquivo", -1);
+  } else {
+    sqlite3_result_int(ctx, s->n);
+  }
+  sqlite3_free(tmp);
+}
+
+/*
+ * Letras base minúsculas das letras do suplemento Latin-1 (U+00C0..U+00FF),
+ * cuja codificação UTF-8 é 0xC3 seguido de 0x80..0xBF, indexadas pelo segundo
+ * byte, tal que string vazia indica separador de palavras (× e ÷).
+*/
+static const char *LATIN1_BASE[64] = {
+  "a", "a", "a", "a", "a", "a", "ae", "c",   /* À Á Â Ã Ä Å Æ Ç */
+  "e", "e", "e", "e", "i", "i", "i", "i",    /* È É Ê Ë Ì Í Î Ï */
+  "d", "n", "o", "o", "o", "o", "o", "",     /* Ð Ñ Ò Ó Ô Õ Ö × */
+  "o", "u", "u", "u", "u", "y", "th", "ss",  /* Ø Ù Ú Û Ü Ý Þ ß */
+  "a", "a", "a", "a", "a", "a", "ae", "c",   /* à á â ã ä å æ ç */
+  "e", "e", "e", "e", "i", "i", "i", "i",    /* è é ê ë ì í î ï */
+  "d", "n", "o", "o", "o", "o", "o", "",     /* ð ñ ò ó ô õ ö ÷ */
+  "o", "u", "u", "u", "u", "y", "th", "y"    /* ø ù ú û ü ý þ ÿ */
+};
+
+/* palavras desconsideradas na normalização de nomes de localidades */
+static const char *STOP_WORDS[] = { "d", "da", "das", "de", "do", "dos", "e", NULL };
+
+/*
+ * Testa se os "n" bytes a partir de "z" compõem uma das "stop words".
+*/
+static int stop_word(const char *z, int n)
+{
+  const char **w;
+  for (w = STOP_WORDS; *w; ++w) {
+    if ((int) strlen(*w) == n && memcmp(*w, z, n) == 0) return 1;
+  }
+  return 0;
+}
+
+/*
+ * Normaliza os "n" bytes do nome de localidade "z" em "rz", que deve ter
+ * capacidade para n+2 bytes, pois as substituições não aumentam o comprimento,
+ * exceto o espaço adicional, retornando o comprimento do resultado.
+*/
+static int normaliza_nome(const unsigned char *z, int n, char *rz)
+{
+  const char *base;
+  int j, k, inicio;
+
+  for (j = k = 0, inicio = -1; j <= n; ) {
+    base = NULL;
+    if (j == n) {
+      base = "";
+      ++j;
+    } else if (z[j] < 0x80) {
+      if (IS_DIGIT(z[j]) || (z[j] >= 'a' && z[j] <= 'z')) {
+        rz[k] = z[j];
+      } else if (z[j] >= 'A' && z[j] <= 'Z') {
+        rz[k] = z[j] ^ 0x20;
+      } else {
+        base = "";
+      }
+      ++j;
+    } else if ((z[j] == 0xC3 || z[j] == 0xC2) && j + 1 < n
+               && (z[j+1] & 0xC0) == 0x80) {
+      if (z[j] == 0xC3) {
+        base = LATIN1_BASE[z[j+1] - 0x80];
+      } else {
+        base = (z[j+1] == 0xAA) ? "a" : (z[j+1] == 0xBA) ? "o" : "";
+      }
+      j += 2;
+    } else {
+      rz[k] = z[j++];
+    }
+
+    if (base && !*base) {
+      // fim de palavra, eliminando-a se é "stop word"
+      if (inicio >= 0 && stop_word(rz + inicio, k - inicio)) {
+        k = inicio > 0 ? inicio - 1 : 0;
+      }
+      inicio = -1;
+      continue;
+    }
+    if (inicio < 0) {
+      // início de palavra precedida de espaço se não é a primeira
+      if (k > 0) {
+        if (base) {
+          rz[k++] = ' ';
+        } else {
+          rz[k+1] = rz[k];
+          rz[k++] = ' ';
+        }
+      }
+      inicio = k;
+    }
+    if (base) {
+      while (*base) rz[k++] = *base++;
+    } else {
+      ++k;
+    }
+  }
+  rz[k] = 0;
+  return k;
+}
+
+/*
+ * Retorna o nome de localidade normalizado para pesquisas indiferentes à caixa
+ * e à acentuação, tal que as letras ASCII e do suplemento Latin-1 são
+ * convertidas em letras base minúsculas, quaisquer outros caractéres ASCII
+ * que não são letras ou algarismos separam palavras, as "stop words" em
+ * português são eliminadas e as palavras são separadas por um único espaço,
+ * e.g.:
+ *
+ *    NORMALIZA('Santa Bárbara d''Oeste') == 'santa barbara oeste'
+ *
+ * Caractéres fora do suplemento Latin-1 são preservados como tal.
+*/
+static void normaliza(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  const unsigned char *z = sqlite3_value_text(argv[0]);
+  char *rz;
+  int n;
+
+  if (!z) {
+    sqlite3_result_null(ctx);
+    return ;
+  }
+  n = sqlite3_value_bytes(argv[0]);
+  rz = sqlite3_malloc(n + 2);
+  if (!rz) {
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+  n = normaliza_nome(z, n, rz);
+  sqlite3_result_text(ctx, rz, n, sqlite3_free);
+}
+
+/* quantidade de registros por INSERT na importação dos ganhadores */
+#define LOTE_GANHADORES 64
+
+typedef struct ganhador_s
+{
+  int concurso;
+  char *linha;            /* linha do arquivo que contém os campos */
+  char *cidade;           /* NULL se o campo é vazio */
+  char *uf;               /* NULL se o campo é vazio */
+  char *cidade_norm;      /* nome normalizado da cidade ou NULL */
+}
+ganhador_t;
+
+static void libera_ganhador(ganhador_t *g)
+{
+  sqlite3_free(g->linha);
+  sqlite3_free(g->cidade_norm);
+}
+
+/*
+ * Prepara o INSERT de "n" registros na tabela "ganhadores".
+*/
+static int prepara_insert_ganhadores(sqlite3 *db, int n, sqlite3_stmt **stmt)
+{
+  char *z = sqlite3_mprintf("INSERT INTO ganhadores (concurso, cidade, uf, cidade_norm)" \
+    " VALUES (?,?,?,?)");
+  int r, j;
+  for (j = 1; z && j < n; ++j) z = sqlite3_mprintf("%z,(?,?,?,?)", z);
+  if (!z) return SQLITE_NOMEM;
+  r = sqlite3_prepare_v2(db, z, -1, stmt, NULL);
+  sqlite3_free(z);
+  return r;
+}
+
+/*
+ * Insere os "n" registros acumulados no lote via INSERT preparado de múltiplos
+ * registros, liberando as linhas do arquivo que os contém e os nomes
+ * normalizados.
+*/
+static int insere_ganhadores(sqlite3_stmt *stmt, ganhador_t *lote, int n)
+{
+  const char *campos[3];
+  int j, k, r;
+  for (j = 0; j < n; ++j) {
+    sqlite3_bind_int(stmt, 4*j+1, lote[j].concurso);
+    campos[0] = lote[j].cidade;
+    campos[1] = lote[j].uf;
+    campos[2] = lote[j].cidade_norm;
+    for (k = 0; k < 3; ++k) {
+      if (campos[k]) {
+        sqlite3_bind_text(stmt, 4*j+k+2, campos[k], -1, SQLITE_STATIC);
+      } else {
+        sqlite3_bind_null(stmt, 4*j+k+2);
+      }
+    }
+  }
+  r = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  for (j = 0; j < n; ++j) libera_ganhador(lote + j);
+  return r == SQLITE_DONE ? SQLITE_OK : r;
+}
+
+/*
+ * Decompõe a linha do arquivo "concurso|cidade|uf" nos campos do registro,
+ * tal que campos vazios são normalizados como NULL, retornando zero se a
+ * linha é mal formada.
+*/
+static int decompoe_ganhador(char *linha, char sep, ganhador_t *g)
+{
+  char *p, *q;
+  int n = strlen(linha);
+  while (n > 0 && (linha[n-1] == '\n' || linha[n-1] == '\r')) linha[--n] = 0;
+  if (!IS_DIGIT(*linha)) return 0;
+  for (g->concurso = 0, p = linha; IS_DIGIT(*p); ++p) g->concurso = g->concurso * 10 + *p - '0';
+  if (*p != sep) return 0;
+  q = strchr(++p, sep);
+  if (!q) return 0;
+  *q++ = 0;
+  g->cidade = *p ? p : NULL;
+  g->uf = *q ? q : NULL;
+  g->linha = linha;
+  g->cidade_norm = NULL;
+  return 1;
+}
+
+/*
+ * Lê a próxima linha do arquivo com qualquer comprimento, retornando a linha
+ * alocada via sqlite3_malloc ou NULL no fim do arquivo ou se a memória é
+ * insuficiente, quando "r" é atualizado com SQLITE_NOMEM.
+*/
+static char *le_linha(FILE *f, int *r)
+{
+  char buffer[1024];
+  sqlite3_str *z;
+  int n;
+
+  if (!fgets(buffer, sizeof(buffer), f)) return NULL;
+  z = sqlite3_str_new(NULL);
+  do {
+    sqlite3_str_appendall(z, buffer);
+    n = strlen(buffer);
+  } while (n > 0 && buffer[n-1] != '\n' && fgets(buffer, sizeof(buffer), f));
+  if (sqlite3_str_errcode(z) != SQLITE_OK) {
+    sqlite3_free(sqlite3_str_finish(z));
+    *r = SQLITE_NOMEM;
+    return NULL;
+  }
+  return sqlite3_str_finish(z);
+}
+
+/*
+ * Importa incrementalmente para a tabela "ganhadores" os registros do arquivo
+ * cujo path é o primeiro argumento, contendo linhas "concurso|cidade|uf" com
+ * separador opcionalmente especificado pelo segundo argumento. Somente são
+ * inseridos os registros dos concursos existentes na tabela "concursos" que
+ * ainda não têm registros de ganhadores, em transação única via INSERTs de
+ * múltiplos registros, com o nome da cidade normalizado tal qual NORMALIZA na
+ * coluna "cidade_norm". Retorna a quantidade de registros inseridos ou erro se
+ * alguma linha não vazia é mal formada, quando nenhum registro é inserido.
+*/
+static void importa_ganhadores(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  sqlite3 *db = sqlite3_context_db_handle(ctx);
+  serie_t *s = (serie_t *) sqlite3_user_data(ctx);
+  sqlite3_stmt *existe = NULL, *lote_stmt = NULL, *unit_stmt = NULL;
+  ganhador_t lote[LOTE_GANHADORES];
+  char *linha, sep = '|';
+  int n = 0, total = 0, anterior = -1, ausente = 0, r, j;
+  int numero = 0, rejeitadas = 0, primeira = 0;
+  FILE *f;
+
+  if (SQLITE3_TEXT != sqlite3_value_type(argv[0])) {
+    sqlite3_result_error(ctx, "primeiro argumento não é do tipo text", -1);
+    return ;
+  }
+  if (argc == 2) {
+    const char *z = (const char *) sqlite3_value_text(argv[1]);
+    if (!z || strlen(z) != 1) {
+      sqlite3_result_error(ctx, "separador não é caractere único", -1);
+      return ;
+    }
+    sep = *z;
+  }
+  r = carrega_serie(db, s);
+  if (r != SQLITE_OK) {
+    erro_serie(ctx, r);
+    return ;
+  }
+  f = fopen((const char *) sqlite3_value_text(argv[0]), "r");
+  if (!f) {
+    sqlite3_result_error(ctx, "arquivo não está disponível", -1);
+    return ;
+  }
+
+  r = sqlite3_exec(db, "SAVEPOINT importa_ganhadores;", NULL, NULL, NULL);
+  if (r == SQLITE_OK) r = sqlite3_prepare_v2(db,
+    "SELECT 1 FROM ganhadores WHERE concurso == ?;", -1, &existe, NULL);
+  if (r == SQLITE_OK) r = prepara_insert_ganhadores(db, LOTE_GANHADORES, &lote_stmt);
+  if (r == SQLITE_OK) r = prepara_insert_ganhadores(db, 1, &unit_stmt);
+
+  while (r == SQLITE_OK && (linha = le_linha(f, &r)) != NULL) {
+    ganhador_t g;
+    ++numero;
+    if (!decompoe_ganhador(linha, sep, &g)) {
+      /* linhas vazias são ignoradas e as mal formadas contabilizadas */
+      if (*linha) {
+        if (!rejeitadas++) primeira = numero;
+      }
+      sqlite3_free(linha);
+      continue;
+    }
+    /* testa a ausência de registros do concurso somente na primeira linha */
+    if (g.concurso != anterior) {
+      anterior = g.concurso;
+      sqlite3_bind_int(existe, 1, g.concurso);
+      ausente = posicao_concurso(s, g.concurso) >= 0
+                && sqlite3_step(existe) != SQLITE_ROW;
+      sqlite3_reset(existe);
+    }
+    if (!ausente) {
+      sqlite3_free(linha);
+      continue;
+    }
+    /* nome normalizado da cidade da coluna indexada "cidade_norm" */
+    if (g.cidade) {
+      int k = strlen(g.cidade);
+      if (!(g.cidade_norm = sqlite3_malloc(k + 2))) {
+        sqlite3_free(linha);
+        r = SQLITE_NOMEM;
+        break;
+      }
+      normaliza_nome((const unsigned char *) g.cidade, k, g.cidade_norm);
+    }
+    lote[n++] = g;
+    if (n == LOTE_GANHADORES) {
+      r = insere_ganhadores(lote_stmt, lote, n);
+      total += n;
+      n = 0;
+    }
+  }
+  /* registros remanescentes inseridos um a um */
+  for (j = 0; j < n; ++j) {
+    if (r == SQLITE_OK) {
+      r = insere_ganhadores(unit_stmt, lote + j, 1);
+      ++total;
+    } else {
+      libera_ganhador(lote + j);
+    }
+  }
+  fclose(f);
+
+  sqlite3_finalize(existe);
+  sqlite3_finalize(lote_stmt);
+  sqlite3_finalize(unit_stmt);
+  if (r == SQLITE_OK && !rejeitadas) {
+    sqlite3_exec(db, "RELEASE importa_ganhadores;", NULL, NULL, NULL);
+    sqlite3_result_int(ctx, total);
+  } else {
+    char *z = r != SQLITE_OK
+      ? sqlite3_mprintf("falha na importação dos ganhadores: %s", sqlite3_errmsg(db))
+      : sqlite3_mprintf("falha na importação dos ganhadores: %d linha(s) mal formada(s)" \
+          " a partir da linha %d", rejeitadas, primeira);
+    sqlite3_exec(db, "ROLLBACK TO importa_ganhadores; RELEASE importa_ganhadores;",
+      NULL, NULL, NULL);
+    sqlite3_result_error(ctx, z, -1);
+    sqlite3_free(z);
+  }
+}
+
+/* parâmetros do hash FNV-1a de 64 bits */
+#define FNV_BASE  0xcbf29ce484222325ULL
+#define FNV_PRIMO 0x100000001b3ULL
+
+static u64 fnv1a(u64 h, const void *p, int n)
+{
+  const unsigned char *z = (const unsigned char *) p;
+  while (n-- > 0) h = (h ^ *z++) * FNV_PRIMO;
+  return h;
+}
+
+/*
+ * Hash FNV-1a dos valores, tal que cada valor contribui com seu tipo seguido
+ * do conteúdo, e textos e blobs também com seus comprimentos, evitando que
+ * valores distintos sejam concatenados no mesmo conteúdo.
+*/
+static u64 digest_valores(int argc, sqlite3_value **argv)
+{
+  u64 h = FNV_BASE;
+  sqlite3_int64 i;
+  double f;
+  int j, n, tipo;
+
+  for (j = 0; j < argc; ++j) {
+    tipo = sqlite3_value_type(argv[j]);
+    h = (h ^ tipo) * FNV_PRIMO;
+    switch (tipo) {
+      case SQLITE_INTEGER:
+        i = sqlite3_value_int64(argv[j]);
+        h = fnv1a(h, &i, sizeof(i));
+        break;
+      case SQLITE_FLOAT:
+        f = sqlite3_value_double(argv[j]);
+        h = fnv1a(h, &f, sizeof(f));
+        break;
+      case SQLITE_TEXT:
+      case SQLITE_BLOB:
+        n = sqlite3_value_bytes(argv[j]);
+        h = fnv1a(h, &n, sizeof(n));
+        h = fnv1a(h, sqlite3_value_blob(argv[j]), n);
+        break;
+    }
+  }
+  return h;
+}
+
+/*
+ * Retorna o digest de 64 bits dos argumentos como inteiro, usado como digest
+ * do conteúdo de cada concurso, e.g. no registro da coluna "digest":
+ *
+ *    SELECT DIGEST(concurso, data_sorteio, ..., acumulada_mega_virada, g)
+*/
+static void digest(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  sqlite3_result_int64(ctx, (sqlite3_int64) digest_valores(argc, argv));
+}
+
+/* estado da função agregada DIGEST_AGG */
+typedef struct digest_agg_s
+{
+  u64 soma;
+  int n;
+}
+digest_agg_t;
+
+/*
+ * Agrega os digests dos argumentos de cada registro por soma módulo 2^64,
+ * tal que o resultado independe da ordem dos registros, e.g. o digest da
+ * lista de ganhadores do concurso:
+ *
+ *    SELECT DIGEST_AGG(cidade, uf) FROM ganhadores WHERE concurso == 1000
+*/
+static void digest_agg_step(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  digest_agg_t *a = (digest_agg_t *) sqlite3_aggregate_context(ctx, sizeof(digest_agg_t));
+  if (!a) {
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+  a->soma += digest_valores(argc, argv);
+  a->n++;
+}
+
+/*
+ * Retorna o digest agregado ou NULL se não há registros.
+*/
+static void digest_agg_final(sqlite3_context *ctx)
+{
+  digest_agg_t *a = (digest_agg_t *) sqlite3_aggregate_context(ctx, 0);
+  if (a && a->n) {
+    sqlite3_result_int64(ctx, (sqlite3_int64) a->soma);
+  } else {
+    sqlite3_result_null(ctx);
+  }
+}
+
+/* formatos de saída da função agregada RENDER_BOLETO */
+#define BOLETO_HTML 0
+#define BOLETO_CSS  1
+#define BOLETO_COLUNAS 10 /* quantidade de células por linha do boleto */
+
+/* estado da função agregada RENDER_BOLETO */
+typedef struct boleto_s
+{
+  char *celula[N_DEZENAS];  /* fragmento renderizado de cada dezena */
+  int formato;
+}
+boleto_t;
+
+/*
+ * Renderiza o fragmento da dezena no formato do agregado, com os valores
+ * numéricos convertidos para texto tal como o SQLite os converte, i.e.; tal
+ * como exibidos pelo shell sqlite3.
+*/
+static char *boleto_celula(int formato, int dezena, sqlite3_value **argv)
+{
+  const char *beta = (const char *) sqlite3_value_text(argv[5]);
+  const char *cor;
+
+  if (formato == BOLETO_HTML) {
+    return sqlite3_mprintf("    <td class=\"dezena%02d\" title=\"dezena %02d&lt;br/&gt;" \
+      "IFR = %s :: foi sorteada em %s concursos e pela última vez há %s concursos\">%02d</td>\n",
+      dezena, dezena, sqlite3_value_text(argv[3]), sqlite3_value_text(argv[1]),
+      sqlite3_value_text(argv[2]), dezena);
+  }
+  /* dígitos em preto somente para as dezenas sorteadas no último concurso */
+  cor = (beta && strcmp(beta, "1.0") == 0) ? "0" : "18";
+  return sqlite3_mprintf("td.dezena%02d {\n" \
+    "  background-color: rgba(240,80,0,%s);\n" \
+    "  color: rgba(%s,%s,%s,%s);\n}\n",
+    dezena, sqlite3_value_text(argv[4]), cor, cor, cor, beta);
+}
+
+/*
+ * Agrega as células do boleto de frequências e latências das dezenas, cujo
+ * resultado é o elemento <tbody> completo da tabela "boleto" do relatório ou
+ * se o argumento opcional "formato" é 'css', o conteúdo de
+ * css/frequencias.css, dispensando uma requisição por célula:
+ *
+ *    SELECT RENDER_BOLETO(dezena, frequencia, latencia, round(ifrap,5),
+ *      alfa, beta [, formato]) FROM ...
+*/
+static void render_boleto_step(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  boleto_t *b = (boleto_t *) sqlite3_aggregate_context(ctx, sizeof(boleto_t));
+  const char *z;
+  int d;
+
+  if (!b) {
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+  if (argc > 6) {
+    z = (const char *) sqlite3_value_text(argv[6]);
+    if (z && sqlite3_stricmp(z, "css") == 0) {
+      b->formato = BOLETO_CSS;
+    } else if (z && sqlite3_stricmp(z, "html") != 0) {
+      sqlite3_result_error(ctx, "formato do boleto é desconhecido", -1);
+      return ;
+    }
+  }
+  d = sqlite3_value_int(argv[0]);
+  if (d < 1 || d > N_DEZENAS) {
+    sqlite3_result_error(ctx, "dezena fora do intervalo [1;60]", -1);
+    return ;
+  }
+  sqlite3_free(b->celula[d-1]);
+  if (!(b->celula[d-1] = boleto_celula(b->formato, d, argv))) {
+    sqlite3_result_error_nomem(ctx);
+  }
+}
+
+/*
+ * Concatena as células em ordem crescente das dezenas num único buffer,
+ * omitindo a quebra de linha final que o shell sqlite3 acrescenta.
+*/
+static void render_boleto_final(sqlite3_context *ctx)
+{
+  boleto_t *b = (boleto_t *) sqlite3_aggregate_context(ctx, 0);
+  sqlite3_str *str;
+  char *z;
+  int d, n;
+
+  if (!b) {
+    sqlite3_result_null(ctx);
+    return ;
+  }
+  str = sqlite3_str_new(sqlite3_context_db_handle(ctx));
+  if (b->formato == BOLETO_HTML) sqlite3_str_appendall(str, "      <tbody>\n");
+  for (d = 0; d < N_DEZENAS; ++d) {
+    if (b->formato == BOLETO_HTML && d % BOLETO_COLUNAS == 0) {
+      sqlite3_str_appendall(str, "        <tr>\n");
+    }
+    if (b->celula[d]) {
+      sqlite3_str_appendall(str, b->celula[d]);
+      sqlite3_free(b->celula[d]);
+    }
+    if (b->formato == BOLETO_HTML && d % BOLETO_COLUNAS == BOLETO_COLUNAS-1) {
+      sqlite3_str_appendall(str, "        </tr>\n");
+    }
+  }
+  if (b->formato == BOLETO_HTML) sqlite3_str_appendall(str, "      </tbody>\n");
+
+  if (sqlite3_str_errcode(str) != SQLITE_OK) {
+    sqlite3_free(sqlite3_str_finish(str));
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+  n = sqlite3_str_length(str);
+  z = sqlite3_str_finish(str);
+  if (n > 0 && z[n-1] == '\n') --n;
+  sqlite3_result_text(ctx, z, n, sqlite3_free);
+}
+
+/*
+ * Mapeia as restrições de igualdade sobre as colunas ocultas a partir da
+ * coluna "primeira", que são os argumentos das funções "table-valued", nos
+ * respectivos argumentos de xFilter na ordem das colunas. O bitmask dos
+ * argumentos informados é atribuído a idxNum e se algum argumento obrigatório
+ * conforme bitmask "requeridos" não foi informado, o plano é desencorajado.
+*/
+static int indexa_argumentos(sqlite3_index_info *info, int primeira, int n, int requeridos)
+{
+  const struct sqlite3_index_constraint *c = info->aConstraint;
+  int j, k, mask = 0, argv[32];
+
+  for (j = 0; j < info->nConstraint; ++j, ++c) {
+    k = c->iColumn - primeira;
+    if (k < 0 || k >= n) continue;
+    if (!c->usable) {
+      if (requeridos & (1 << k)) return SQLITE_CONSTRAINT;
+      continue;
+    }
+    if (c->op != SQLITE_INDEX_CONSTRAINT_EQ) continue;
+    mask |= 1 << k;
+    argv[k] = j;
+  }
+  if ((mask & requeridos) != requeridos) {
+    info->estimatedCost = 1e99;
+    return SQLITE_CONSTRAINT;
+  }
+  for (j = 0, k = 0; k < n; ++k) {
+    if (mask & (1 << k)) {
+      info->aConstraintUsage[argv[k]].argvIndex = ++j;
+      info->aConstraintUsage[argv[k]].omit = 1;
+    }
+  }
+  info->idxNum = mask;
+  info->estimatedCost = 1000;
+  return SQLITE_OK;
+}
+
+/* cursor genérico das tabelas virtuais sobre a série */
+typedef struct serie_vtab_s
+{
+  sqlite3_vtab base;
+  sqlite3 *db;
+  serie_t *serie;
+}
+serie_vtab;
+
+static int serie_disconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+/*
+ * Conexão comum das tabelas virtuais sobre a série, cujo esquema é declarado
+ * pela string "ddl".
+*/
+static int serie_connect_ddl(sqlite3 *db, void *aux, sqlite3_vtab **ppVtab,
+  char **err, const char *ddl)
+{
+  serie_vtab *v;
+  int r = sqlite3_declare_vtab(db, ddl);
+  if (r != SQLITE_OK) return r;
+  v = (serie_vtab *) sqlite3_malloc(sizeof(serie_vtab));
+  if (!v) return SQLITE_NOMEM;
+  memset(v, 0, sizeof(serie_vtab));
+  v->db = db;
+  v->serie = (serie_t *) aux;
+  *ppVtab = &v->base;
+  return SQLITE_OK;
+}
+
+/*
+ * Carrega o cache da série no contexto de xFilter notificando falhas na
+ * mensagem de erro da tabela virtual.
+*/
+static int serie_vtab_carrega(serie_vtab *v)
+{
+  int r = carrega_serie(v->db, v->serie);
+  if (r != SQLITE_OK && r != SQLITE_NOMEM) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("falha na carga da série dos concursos: %s",
+      sqlite3_errmsg(v->db));
+  }
+  return r;
+}
+
+/*
+ * JANELA(n) desliza uma janela de "n" concursos sobre a série, emitindo para
+ * cada concurso as frequências das dezenas nos concursos da janela que termina
+ * nele, a entropia de Shannon (em bits) da distribuição dessas frequências e a
+ * estatística chi-quadrado do teste de aderência à distribuição uniforme, com
+ * 59 graus de liberdade. Cada passo soma as 6 dezenas do concurso que entra e
+ * subtrai as 6 dezenas do concurso que sai, atualizando incrementalmente as
+ * somas de f² e f·log₂(f) das quais derivam as estatísticas.
+ * Nos primeiros n-1 concursos a janela é parcial, conforme a coluna "tamanho".
+ *
+ *    SELECT concurso, entropia, chi FROM janela(100) WHERE tamanho == 100;
+*/
+typedef struct janela_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  int n;                  /* tamanho da janela */
+  int i;                  /* posição do concurso corrente na série */
+  int freq[N_DEZENAS];    /* frequências das dezenas na janela */
+  int total;              /* soma das frequências */
+  double soma2;           /* soma dos quadrados das frequências */
+  double somalog;         /* soma de f·log₂(f) */
+}
+janela_cursor;
+
+enum { JANELA_CONCURSO, JANELA_TAMANHO, JANELA_FREQUENCIAS, JANELA_ENTROPIA,
+       JANELA_CHI, JANELA_N };
+
+static int janela_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(concurso INTEGER," \
+    " tamanho INTEGER, frequencias TEXT, entropia REAL, chi REAL, n HIDDEN)");
+}
+
+static int janela_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  return indexa_argumentos(info, JANELA_N, 1, 1);
+}
+
+static int janela_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  janela_cursor *c = (janela_cursor *) sqlite3_malloc(sizeof(janela_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(janela_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int janela_close(sqlite3_vtab_cursor *cur)
+{
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+#define FLOG2(f) ((f) > 1 ? (f) * log2((double) (f)) : 0.0)
+
+/* Soma "delta" (+1 ou -1) às frequências das dezenas da máscara. */
+static void janela_acumula(janela_cursor *c, u64 mask, int delta)
+{
+  while (mask) {
+    int d = __builtin_ctzll(mask);
+    int f = c->freq[d];
+    c->soma2 += delta * (2.0 * f + delta);
+    c->somalog += FLOG2(f + delta) - FLOG2(f);
+    c->freq[d] = f + delta;
+    c->total += delta;
+    mask &= mask - 1;
+  }
+}
+
+static int janela_next(sqlite3_vtab_cursor *cur)
+{
+  janela_cursor *c = (janela_cursor *) cur;
+  serie_t *s = ((serie_vtab *) cur->pVtab)->serie;
+  if (++c->i < s->n) {
+    janela_acumula(c, s->dezenas[c->i], +1);
+    if (c->i >= c->n) janela_acumula(c, s->dezenas[c->i - c->n], -1);
+  }
+  return SQLITE_OK;
+}
+
+static int janela_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  janela_cursor *c = (janela_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  int r;
+
+  if (SQLITE_INTEGER != sqlite3_value_numeric_type(argv[0])
+      || sqlite3_value_int(argv[0]) < 1) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("tamanho da janela não é inteiro positivo");
+    return SQLITE_ERROR;
+  }
+  if ((r = serie_vtab_carrega(v)) != SQLITE_OK) return r;
+  memset(c->freq, 0, sizeof(c->freq));
+  c->n = sqlite3_value_int(argv[0]);
+  c->total = 0;
+  c->soma2 = c->somalog = 0;
+  c->i = -1;
+  return janela_next(cur);
+}
+
+static int janela_eof(sqlite3_vtab_cursor *cur)
+{
+  janela_cursor *c = (janela_cursor *) cur;
+  return c->i >= ((serie_vtab *) cur->pVtab)->serie->n;
+}
+
+static int janela_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  janela_cursor *c = (janela_cursor *) cur;
+  serie_t *s = ((serie_vtab *) cur->pVtab)->serie;
+  double e;
+
+  switch (k) {
+    case JANELA_CONCURSO:
+      sqlite3_result_int(ctx, s->concurso[c->i]);
+      break;
+    case JANELA_TAMANHO:
+      sqlite3_result_int(ctx, c->i < c->n ? c->i + 1 : c->n);
+      break;
+    case JANELA_FREQUENCIAS: {
+      char *z = sqlite3_malloc(N_DEZENAS * 12);
+      int j, m;
+      if (!z) return SQLITE_NOMEM;
+      for (j = m = 0; j < N_DEZENAS; ++j) {
+        m += sprintf(z + m, j ? " %d" : "%d", c->freq[j]);
+      }
+      sqlite3_result_text(ctx, z, m, sqlite3_free);
+      break;
+    }
+    case JANELA_ENTROPIA:
+      sqlite3_result_double(ctx, log2((double) c->total) - c->somalog / c->total);
+      break;
+    case JANELA_CHI:
+      e = c->total / (double) N_DEZENAS;
+      sqlite3_result_double(ctx, c->soma2 / e - c->total);
+      break;
+    case JANELA_N:
+      sqlite3_result_int(ctx, c->n);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int janela_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((janela_cursor *) cur)->i + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module janela_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  janela_connect,
+  janela_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  janela_open,
+  janela_close,
+  janela_filter,
+  janela_next,
+  janela_eof,
+  janela_column,
+  janela_rowid,
+};
+
+/*
+ * EVOLUCAO([inicio]) emite para cada concurso e cada dezena, a frequência
+ * acumulada e a latência da dezena até o concurso inclusive, calculadas
+ * incrementalmente numa única passagem pela série, que são os dados dos quadros
+ * da animação das evoluções das frequências e latências. O argumento opcional
+ * é o número do primeiro concurso a emitir, sem prejuízo do cálculo que sempre
+ * parte do primeiro concurso da série.
+ *
+ *    SELECT * FROM evolucao(1500) WHERE dezena == 10;
+*/
+typedef struct evolucao_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  int inicio;             /* número do primeiro concurso emitido */
+  int i;                  /* posição do concurso corrente na série */
+  int d;                  /* índice da dezena corrente */
+  int freq[N_DEZENAS];    /* frequências acumuladas das dezenas */
+  int ultimo[N_DEZENAS];  /* concurso mais recente em que a dezena foi sorteada */
+}
+evolucao_cursor;
+
+enum { EVOLUCAO_CONCURSO, EVOLUCAO_DEZENA, EVOLUCAO_FREQUENCIA, EVOLUCAO_LATENCIA,
+       EVOLUCAO_INICIO };
+
+static int evolucao_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(concurso INTEGER," \
+    " dezena INTEGER, frequencia INTEGER, latencia INTEGER, inicio HIDDEN)");
+}
+
+static int evolucao_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  return indexa_argumentos(info, EVOLUCAO_INICIO, 1, 0);
+}
+
+static int evolucao_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  evolucao_cursor *c = (evolucao_cursor *) sqlite3_malloc(sizeof(evolucao_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(evolucao_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+/* Avança a série até o concurso de posição "i" inclusive. */
+static void evolucao_avanca(evolucao_cursor *c, const serie_t *s, int i)
+{
+  while (c->i < i && ++c->i < s->n) {
+    u64 mask = s->dezenas[c->i];
+    while (mask) {
+      int d = __builtin_ctzll(mask);
+      c->freq[d]++;
+      c->ultimo[d] = s->concurso[c->i];
+      mask &= mask - 1;
+    }
+  }
+}
+
+static int evolucao_next(sqlite3_vtab_cursor *cur)
+{
+  evolucao_cursor *c = (evolucao_cursor *) cur;
+  if (++c->d == N_DEZENAS) {
+    c->d = 0;
+    evolucao_avanca(c, ((serie_vtab *) cur->pVtab)->serie, c->i + 1);
+  }
+  return SQLITE_OK;
+}
+
+static int evolucao_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  evolucao_cursor *c = (evolucao_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  serie_t *s = v->serie;
+  int r;
+
+  if ((r = serie_vtab_carrega(v)) != SQLITE_OK) return r;
+  memset(c->freq, 0, sizeof(c->freq));
+  memset(c->ultimo, 0, sizeof(c->ultimo));
+  c->inicio = (argc > 0) ? sqlite3_value_int(argv[0]) : 0;
+  c->i = -1;
+  c->d = 0;
+  /* posiciona no primeiro concurso emitido acumulando os anteriores */
+  for (r = 0; r < s->n && s->concurso[r] < c->inicio; ++r) ;
+  evolucao_avanca(c, s, r);
+  return SQLITE_OK;
+}
+
+static int evolucao_eof(sqlite3_vtab_cursor *cur)
+{
+  evolucao_cursor *c = (evolucao_cursor *) cur;
+  return c->i < 0 || c->i >= ((serie_vtab *) cur->pVtab)->serie->n;
+}
+
+static int evolucao_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  evolucao_cursor *c = (evolucao_cursor *) cur;
+  serie_t *s = ((serie_vtab *) cur->pVtab)->serie;
+
+  switch (k) {
+    case EVOLUCAO_CONCURSO:
+      sqlite3_result_int(ctx, s->concurso[c->i]);
+      break;
+    case EVOLUCAO_DEZENA:
+      sqlite3_result_int(ctx, c->d + 1);
+      break;
+    case EVOLUCAO_FREQUENCIA:
+      sqlite3_result_int(ctx, c->freq[c->d]);
+      break;
+    case EVOLUCAO_LATENCIA:
+      sqlite3_result_int(ctx, s->concurso[c->i] - c->ultimo[c->d]);
+      break;
+    case EVOLUCAO_INICIO:
+      sqlite3_result_int(ctx, c->inicio);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int evolucao_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  evolucao_cursor *c = (evolucao_cursor *) cur;
+  *pRowid = (sqlite_int64) c->i * N_DEZENAS + c->d + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module evolucao_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  evolucao_connect,
+  evolucao_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  evolucao_open,
+  janela_close,
+  evolucao_filter,
+  evolucao_next,
+  evolucao_eof,
+  evolucao_column,
+  evolucao_rowid,
+};
+
+/*
+ * GANHADORES_XML(arquivo) extrai do xml gerado a partir do html baixado do
+ * website, os registros (concurso, cidade, uf) dos ganhadores da sena na ordem
+ * do documento, com o mesmo conteúdo da transformação "xsl/ganhadores.xsl",
+ * exceto que campos vazios são NULL. O documento é lido sequencialmente numa
+ * única passagem, sem montagem da árvore, onde cada linha da tabela com
+ * ganhadores informa a localidade do primeiro ganhador e as localidades dos
+ * demais estão nas linhas seguintes, que contém somente duas células.
+ *
+ * Tal qual a transformação, as linhas seguintes são tomadas conforme a
+ * quantidade de ganhadores, mesmo que sejam linhas de outros concursos, cujos
+ * registros são então vazios, e toda linha com ganhadores inicia os registros
+ * do seu concurso. Se o concurso informa menos linhas de ganhadores que sua
+ * quantidade, a leitura é retomada na primeira linha com ganhadores tomada
+ * pelo concurso, portanto o documento só é relido se é mal formado.
+ *
+ *    SELECT * FROM ganhadores_xml('MEGA.XML') WHERE concurso > 2000;
+*/
+#define XML_CELULAS 32    /* quantidade de células com offset registrado */
+
+typedef struct ganhadores_xml_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  FILE *f;
+  char *texto;            /* conteúdos das células da linha corrente */
+  int n;                  /* comprimento utilizado do buffer "texto" */
+  int capacidade;         /* comprimento alocado do buffer "texto" */
+  int celula[XML_CELULAS];  /* offsets dos conteúdos das células */
+  int ncelulas;           /* quantidade de células da linha corrente */
+  char *concurso;         /* número do concurso corrente */
+  int restantes;          /* linhas de ganhadores pendentes do concurso */
+  long retorno;           /* offset da linha com ganhadores a reler ou -1 */
+  const char *cidade;     /* NULL se o campo é vazio */
+  const char *uf;         /* NULL se o campo é vazio */
+  int eof;
+  sqlite_int64 rowid;
+}
+ganhadores_xml_cursor;
+
+enum { GANHADORES_XML_CONCURSO, GANHADORES_XML_CIDADE, GANHADORES_XML_UF,
+       GANHADORES_XML_ARQUIVO };
+
+static int ganhadores_xml_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  int r = serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(concurso INTEGER," \
+    " cidade TEXT, uf TEXT, arquivo HIDDEN)");
+#ifdef SQLITE_VTAB_DIRECTONLY
+  /* lê arquivos arbitrários, portanto não é acessível via views e triggers */
+  if (r == SQLITE_OK) sqlite3_vtab_config(db, SQLITE_VTAB_DIRECTONLY);
+#endif
+  return r;
+}
+
+static int ganhadores_xml_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  return indexa_argumentos(info, GANHADORES_XML_ARQUIVO, 1, 1);
+}
+
+static int ganhadores_xml_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  ganhadores_xml_cursor *c = (ganhadores_xml_cursor *) sqlite3_malloc(sizeof(ganhadores_xml_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(ganhadores_xml_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int ganhadores_xml_close(sqlite3_vtab_cursor *cur)
+{
+  ganhadores_xml_cursor *c = (ganhadores_xml_cursor *) cur;
+  if (c->f) fclose(c->f);
+  sqlite3_free(c->texto);
+  sqlite3_free(c->concurso);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/* Acrescenta o byte ao conteúdo da célula corrente. */
+static int xml_acrescenta(ganhadores_xml_cursor *c, int ch)
+{
+  if (c->n == c->capacidade) {
+    int capacidade = c->capacidade ? 2 * c->capacidade : 256;
+    char *z = sqlite3_realloc(c->texto, capacidade);
+    if (!z) return SQLITE_NOMEM;
+    c->texto = z;
+    c->capacidade = capacidade;
+  }
+  c->texto[c->n++] = ch;
+  return SQLITE_OK;
+}
+
+/* Acrescenta o code point "u" codificado em UTF-8. */
+static int xml_acrescenta_utf8(ganhadores_xml_cursor *c, unsigned u)
+{
+  int r = SQLITE_OK;
+  if (u < 0x80) {
+    r = xml_acrescenta(c, u);
+  } else if (u < 0x800) {
+    if (!(r = xml_acrescenta(c, 0xC0 | (u >> 6))))
+      r = xml_acrescenta(c, 0x80 | (u & 0x3F));
+  } else if (u < 0x10000) {
+    if (!(r = xml_acrescenta(c, 0xE0 | (u >> 12))))
+      if (!(r = xml_acrescenta(c, 0x80 | ((u >> 6) & 0x3F))))
+        r = xml_acrescenta(c, 0x80 | (u & 0x3F));
+  } else {
+    if (!(r = xml_acrescenta(c, 0xF0 | (u >> 18))))
+      if (!(r = xml_acrescenta(c, 0x80 | ((u >> 12) & 0x3F))))
+        if (!(r = xml_acrescenta(c, 0x80 | ((u >> 6) & 0x3F))))
+          r = xml_acrescenta(c, 0x80 | (u & 0x3F));
+  }
+  return r;
+}
+
+/*
+ * Decodifica a referência a entidade predefinida ou a caractere cujo '&'
+ * inicial já foi lido, acrescentando literalmente as referências desconhecidas.
+*/
+static int xml_entidade(ganhadores_xml_cursor *c)
+{
+  char nome[12];
+  int ch, k = 0, r = SQLITE_OK;
+
+  while (k < (int) sizeof(nome) - 1 && (ch = getc(c->f)) != EOF && ch != ';') {
+    nome[k++] = ch;
+  }
+  nome[k] = 0;
+  if (ch == ';') {
+    if (!strcmp(nome, "amp")) return xml_acrescenta(c, '&');
+    if (!strcmp(nome, "lt")) return xml_acrescenta(c, '<');
+    if (!strcmp(nome, "gt")) return xml_acrescenta(c, '>');
+    if (!strcmp(nome, "quot")) return xml_acrescenta(c, '"');
+    if (!strcmp(nome, "apos")) return xml_acrescenta(c, '\'');
+    if (nome[0] == '#') {
+      unsigned long u = (nome[1] == 'x') ? strtoul(nome + 2, NULL, 16) : strtoul(nome + 1, NULL, 10);
+      if (u > 0 && u < 0x110000) return xml_acrescenta_utf8(c, u);
+    }
+  }
+  r = xml_acrescenta(c, '&');
+  for (ch = 0; r == SQLITE_OK && ch < k; ++ch) r = xml_acrescenta(c, nome[ch]);
+  if (r == SQLITE_OK && k < (int) sizeof(nome) - 1 && !feof(c->f)) r = xml_acrescenta(c, ';');
+  return r;
+}
+
+/*
+ * Salta o conteúdo de comentário, declaração ou instrução de processamento
+ * até a sequência final "fim", exceto seções CDATA, cujo conteúdo é acrescentado
+ * à célula corrente se "na_celula" não é zero.
+*/
+static int xml_salta(ganhadores_xml_cursor *c, const char *fim, int na_celula)
+{
+  int ch, j, k = 0, m = strlen(fim), r = SQLITE_OK;
+  while (r == SQLITE_OK && k < m && (ch = getc(c->f)) != EOF) {
+    if (ch == fim[k]) {
+      ++k;
+    } else if (k > 0 && ch == fim[0] && fim[k-1] == fim[0]) {
+      /* repetição do primeiro caractere da sequência final e.g.; "]]]>" */
+      if (na_celula) r = xml_acrescenta(c, ch);
+    } else {
+      for (j = 0; na_celula && r == SQLITE_OK && j < k; ++j) r = xml_acrescenta(c, fim[j]);
+      k = (ch == fim[0]);
+      if (!k && na_celula && r == SQLITE_OK) r = xml_acrescenta(c, ch);
+    }
+  }
+  return r;
+}
+
+/* Encerra o conteúdo da célula corrente. */
+static int xml_fecha_celula(ganhadores_xml_cursor *c)
+{
+  int r = xml_acrescenta(c, 0);
+  c->ncelulas++;
+  return r;
+}
+
+/*
+ * Lê a próxima linha da tabela i.e.; elemento "tr", registrando os conteúdos
+ * textuais das suas células i.e.; elementos "td". Retorna SQLITE_ROW se a
+ * linha foi lida ou SQLITE_DONE no fim do arquivo.
+*/
+static int xml_le_linha(ganhadores_xml_cursor *c)
+{
+  FILE *f = c->f;
+  int ch, na_celula = 0, r = SQLITE_OK;
+
+  c->ncelulas = c->n = 0;
+  while (r == SQLITE_OK && (ch = getc(f)) != EOF) {
+    if (ch == '<') {
+      char nome[4];
+      int k = 0, fecha = 0, q = 0, anterior = 0;
+      ch = getc(f);
+      if (ch == '!') {
+        char prefixo[8];
+        while (k < 7 && (ch = getc(f)) != EOF && ch != '>') {
+          prefixo[k++] = ch;
+          if ((k == 2 && !strncmp(prefixo, "--", 2))
+              || (k == 7 && !strncmp(prefixo, "[CDATA[", 7))) break;
+        }
+        if (ch == '>' || ch == EOF) continue;
+        if (k == 2) {
+          r = xml_salta(c, "-->", 0);
+        } else if (k == 7) {
+          r = xml_salta(c, "]]>", na_celula);
+        } else {
+          r = xml_salta(c, ">", 0);
+        }
+        continue;
+      }
+      if (ch == '?') {
+        r = xml_salta(c, "?>", 0);
+        continue;
+      }
+      if (ch == '/') {
+        fecha = 1;
+        ch = getc(f);
+      }
+      while (ch != EOF && ch != '>' && ch != '/' && !isspace(ch)) {
+        if (k < (int) sizeof(nome)) nome[k] = ch;
+        ++k;
+        ch = getc(f);
+      }
+      /* salta atributos até o fim da tag, anotando se é elemento vazio */
+      while (ch != EOF && ch != '>') {
+        if (q) {
+          if (ch == q) q = 0;
+        } else if (ch == '"' || ch == '\'') {
+          q = ch;
+        }
+        anterior = ch;
+        ch = getc(f);
+      }
+      if (ch == EOF || k != 2) continue;
+      if (!strncmp(nome, "tr", 2)) {
+        if (fecha || anterior == '/') {
+          if (na_celula) r = xml_fecha_celula(c);
+          return r == SQLITE_OK ? SQLITE_ROW : r;
+        }
+        c->ncelulas = c->n = 0;
+        na_celula = 0;
+      } else if (!strncmp(nome, "td", 2)) {
+        if (na_celula) {
+          r = xml_fecha_celula(c);
+          na_celula = 0;
+        }
+        if (!fecha && r == SQLITE_OK) {
+          if (c->ncelulas < XML_CELULAS) c->celula[c->ncelulas] = c->n;
+          if (anterior == '/') {
+            r = xml_fecha_celula(c);
+          } else {
+            na_celula = 1;
+          }
+        }
+      }
+    } else if (na_celula) {
+      r = (ch == '&') ? xml_entidade(c) : xml_acrescenta(c, ch);
+    }
+  }
+  return r == SQLITE_OK ? SQLITE_DONE : r;
+}
+
+/* Retorna o conteúdo da célula "k" da linha corrente ou NULL se vazio. */
+static const char *xml_celula(ganhadores_xml_cursor *c, int k)
+{
+  const char *z;
+  if (k >= c->ncelulas || k >= XML_CELULAS) return NULL;
+  z = c->texto + c->celula[k];
+  return *z ? z : NULL;
+}
+
+/*
+ * Avalia o conteúdo da célula como número conforme a função number() do
+ * XPath, retornando zero se não é numérico.
+*/
+static double xml_numero(const char *z)
+{
+  char *fim;
+  double x;
+  if (!z) return 0;
+  while (isspace((unsigned char) *z)) ++z;
+  if (!IS_DIGIT(*z) && *z != '-' && *z != '.') return 0;
+  x = strtod(z, &fim);
+  if (fim == z) return 0;
+  while (isspace((unsigned char) *fim)) ++fim;
+  return *fim ? 0 : x;
+}
+
+static int ganhadores_xml_next(sqlite3_vtab_cursor *cur)
+{
+  ganhadores_xml_cursor *c = (ganhadores_xml_cursor *) cur;
+  double ganhadores;
+  long offset;
+  int r;
+
+  for (;;) {
+    if (c->restantes > 0) {
+      /* linha de ganhador adicional do concurso corrente */
+      offset = ftell(c->f);
+      r = xml_le_linha(c);
+      if (r == SQLITE_ROW) {
+        c->restantes--;
+        if (c->retorno < 0 && xml_numero(xml_celula(c, 9)) > 0) c->retorno = offset;
+        if (c->ncelulas == 2) {
+          c->cidade = xml_celula(c, 0);
+          c->uf = xml_celula(c, 1);
+        } else {
+          c->cidade = c->uf = NULL;
+        }
+        break;
+      }
+      if (r != SQLITE_DONE) return r;
+      c->restantes = 0;
+    }
+    /* retoma a leitura na linha com ganhadores tomada pelo concurso anterior */
+    if (c->retorno >= 0) {
+      if (fseek(c->f, c->retorno, SEEK_SET) != 0) return SQLITE_IOERR;
+      c->retorno = -1;
+    }
+    r = xml_le_linha(c);
+    if (r != SQLITE_ROW) break;
+    /* linha de concurso com ganhadores i.e.; décima célula positiva */
+    ganhadores = xml_numero(xml_celula(c, 9));
+    if (ganhadores > 0) {
+      const char *z = xml_celula(c, 0);
+      sqlite3_free(c->concurso);
+      c->concurso = z ? sqlite3_mprintf("%s", z) : NULL;
+      if (z && !c->concurso) return SQLITE_NOMEM;
+      c->restantes = (int) ceil(ganhadores) - 1;
+      c->cidade = xml_celula(c, 10);
+      c->uf = xml_celula(c, 11);
+      break;
+    }
+  }
+  if (r == SQLITE_DONE) {
+    c->eof = 1;
+    return SQLITE_OK;
+  }
+  if (r != SQLITE_ROW) return r;
+  c->rowid++;
+  return SQLITE_OK;
+}
+
+static int ganhadores_xml_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  ganhadores_xml_cursor *c = (ganhadores_xml_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+
+  if (c->f) fclose(c->f);
+  c->f = NULL;
+  if (SQLITE3_TEXT == sqlite3_value_type(argv[0])) {
+    c->f = fopen((const char *) sqlite3_value_text(argv[0]), "r");
+  }
+  if (!c->f) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("arquivo não está disponível");
+    return SQLITE_ERROR;
+  }
+  c->restantes = 0;
+  c->retorno = -1;
+  c->eof = 0;
+  c->rowid = 0;
+  return ganhadores_xml_next(cur);
+}
+
+static int ganhadores_xml_eof(sqlite3_vtab_cursor *cur)
+{
+  return ((ganhadores_xml_cursor *) cur)->eof;
+}
+
+static int ganhadores_xml_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  ganhadores_xml_cursor *c = (ganhadores_xml_cursor *) cur;
+  const char *z;
+
+  switch (k) {
+    case GANHADORES_XML_CONCURSO:
+      /* número do concurso como inteiro se é composto somente de dígitos */
+      for (z = c->concurso; z && IS_DIGIT(*z); ++z) ;
+      if (z && !*z && z != c->concurso && z - c->concurso < 10) {
+        sqlite3_result_int(ctx, atoi(c->concurso));
+      } else if (c->concurso) {
+        sqlite3_result_text(ctx, c->concurso, -1, SQLITE_TRANSIENT);
+      }
+      break;
+    case GANHADORES_XML_CIDADE:
+      if (c->cidade) sqlite3_result_text(ctx, c->cidade, -1, SQLITE_TRANSIENT);
+      break;
+    case GANHADORES_XML_UF:
+      if (c->uf) sqlite3_result_text(ctx, c->uf, -1, SQLITE_TRANSIENT);
+      break;
+    case GANHADORES_XML_ARQUIVO:
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int ganhadores_xml_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((ganhadores_xml_cursor *) cur)->rowid;
+  return SQLITE_OK;
+}
+
+static sqlite3_module ganhadores_xml_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  ganhadores_xml_connect,
+  ganhadores_xml_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  ganhadores_xml_open,
+  ganhadores_xml_close,
+  ganhadores_xml_filter,
+  ganhadores_xml_next,
+  ganhadores_xml_eof,
+  ganhadores_xml_column,
+  ganhadores_xml_rowid,
+};
+
+/*
+ * SORTEIOS_ENTRE(data1 [, data2]) emite os concursos sorteados entre as datas
+ * inclusive, expressas como strings no formato YYYY-MM-DD ou DD-MM-YYYY ou como
+ * números de dias desde 1970-01-01 tal qual a coluna "concursos.dia". Sem a
+ * segunda data, emite os concursos sorteados desde a primeira. O intervalo é
+ * localizado por pesquisa binária sobre os dias dos sorteios no cache, que
+ * são crescentes com os números dos concursos.
+ *
+ *    SELECT count(*) FROM sorteios_entre('2020-01-01', '2020-12-31');
+*/
+typedef struct sorteios_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  int i;                  /* posição do concurso corrente na série */
+  int fim;                /* posição seguinte ao último concurso emitido */
+  int dia[2];             /* argumentos como números de dias */
+}
+sorteios_cursor;
+
+enum { SORTEIOS_CONCURSO, SORTEIOS_DATA_SORTEIO, SORTEIOS_DIA, SORTEIOS_DEZENAS,
+       SORTEIOS_ACUMULADO, SORTEIOS_DATA1, SORTEIOS_DATA2 };
+
+static int sorteios_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(concurso INTEGER," \
+    " data_sorteio TEXT, dia INTEGER, dezenas INTEGER, acumulado INTEGER," \
+    " data1 HIDDEN, data2 HIDDEN)");
+}
+
+static int sorteios_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  return indexa_argumentos(info, SORTEIOS_DATA1, 2, 1);
+}
+
+static int sorteios_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  sorteios_cursor *c = (sorteios_cursor *) sqlite3_malloc(sizeof(sorteios_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(sorteios_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+/*
+ * Converte o argumento de data no número de dias desde 1970-01-01, retornando
+ * zero se o argumento não é inteiro nem string de data num dos formatos.
+*/
+static int argumento_dia(sqlite3_value *v, int *dia)
+{
+  const unsigned char *z;
+  unsigned char iso[11];
+  int j;
+
+  if (SQLITE_INTEGER == sqlite3_value_type(v)) {
+    *dia = sqlite3_value_int(v);
+    return 1;
+  }
+  if (SQLITE3_TEXT != sqlite3_value_type(v) || sqlite3_value_bytes(v) != 10) return 0;
+  z = sqlite3_value_text(v);
+  if (z[2] == '-' && z[5] == '-') {
+    /* DD-MM-YYYY */
+    memcpy(iso, z + 6, 4);
+    iso[4] = iso[7] = '-';
+    memcpy(iso + 5, z + 3, 2);
+    memcpy(iso + 8, z, 2);
+    iso[10] = 0;
+    z = iso;
+  }
+  for (j = 0; j < 10; ++j) {
+    if ((j == 4 || j == 7) ? z[j] != '-' : !IS_DIGIT(z[j])) return 0;
+  }
+  j = (z[5] - '0') * 10 + z[6] - '0';
+  if (j < 1 || j > 12) return 0;
+  j = (z[8] - '0') * 10 + z[9] - '0';
+  if (j < 1 || j > 31) return 0;
+  *dia = data_to_dia(z);
+  return 1;
+}
+
+/* Posição do primeiro concurso sorteado no dia ou após o dia. */
+static int posicao_dia(const serie_t *s, int dia)
+{
+  int lo = 0, hi = s->n;
+  while (lo < hi) {
+    int m = lo + (hi - lo) / 2;
+    if (s->dia[m] < dia) lo = m + 1; else hi = m;
+  }
+  return lo;
+}
+
+static int sorteios_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  sorteios_cursor *c = (sorteios_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  serie_t *s = v->serie;
+  int j, r;
+
+  c->dia[1] = 0x7FFFFFFF;
+  for (j = 0; j < argc; ++j) {
+    if (!argumento_dia(argv[j], c->dia + j)) {
+      sqlite3_free(v->base.zErrMsg);
+      v->base.zErrMsg = sqlite3_mprintf("argumento #%d não contém data valida", j+1);
+      return SQLITE_ERROR;
+    }
+  }
+  if ((r = serie_vtab_carrega(v)) != SQLITE_OK) return r;
+  c->i = posicao_dia(s, c->dia[0]);
+  c->fim = (c->dia[1] == 0x7FFFFFFF) ? s->n : posicao_dia(s, c->dia[1] + 1);
+  return SQLITE_OK;
+}
+
+static int sorteios_next(sqlite3_vtab_cursor *cur)
+{
+  ((sorteios_cursor *) cur)->i++;
+  return SQLITE_OK;
+}
+
+static int sorteios_eof(sqlite3_vtab_cursor *cur)
+{
+  sorteios_cursor *c = (sorteios_cursor *) cur;
+  return c->i >= c->fim;
+}
+
+static int sorteios_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  sorteios_cursor *c = (sorteios_cursor *) cur;
+  serie_t *s = ((serie_vtab *) cur->pVtab)->serie;
+  char z[16];
+
+  switch (k) {
+    case SORTEIOS_CONCURSO:
+      sqlite3_result_int(ctx, s->concurso[c->i]);
+      break;
+    case SORTEIOS_DATA_SORTEIO:
+      dia_to_data(s->dia[c->i], z, sizeof(z));
+      sqlite3_result_text(ctx, z, -1, SQLITE_TRANSIENT);
+      break;
+    case SORTEIOS_DIA:
+      sqlite3_result_int(ctx, s->dia[c->i]);
+      break;
+    case SORTEIOS_DEZENAS:
+      sqlite3_result_int64(ctx, (sqlite3_int64) s->dezenas[c->i]);
+      break;
+    case SORTEIOS_ACUMULADO:
+      sqlite3_result_int(ctx, s->acumulado[c->i]);
+      break;
+    case SORTEIOS_DATA1:
+    case SORTEIOS_DATA2:
+      sqlite3_result_int(ctx, c->dia[k - SORTEIOS_DATA1]);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int sorteios_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((sorteios_cursor *) cur)->i + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module sorteios_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  sorteios_connect,
+  sorteios_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  sorteios_open,
+  janela_close,
+  sorteios_filter,
+  sorteios_next,
+  sorteios_eof,
+  sorteios_column,
+  sorteios_rowid,
+};
+
+/*
+ * RUNS(coluna) emite as sequências de valores iguais consecutivos da coluna
+ * informada da tabela "concursos" em ordem crescente dos concursos, i.e.; o
+ * valor de cada sequência, seu comprimento e os números dos concursos inicial
+ * e final, lendo a coluna numa única passagem sem acumular a série. O
+ * histograma dos comprimentos é obtido por agrupamento das sequências, e.g.
+ * dos períodos em que a mega-sena acumulou:
+ *
+ *    SELECT comprimento, count(*) FROM runs('acumulado') WHERE valor == 1
+ *      GROUP BY comprimento;
+*/
+typedef struct runs_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  sqlite3_stmt *stmt;     /* requisição dos valores em ordem dos concursos */
+  int pendente;           /* stmt posicionado no início da sequência seguinte */
+  sqlite3_value *valor;   /* valor da sequência corrente */
+  int comprimento;
+  int inicio, fim;        /* concursos inicial e final da sequência */
+  int eof;
+  sqlite_int64 rowid;
+}
+runs_cursor;
+
+enum { RUNS_VALOR, RUNS_COMPRIMENTO, RUNS_INICIO, RUNS_FIM, RUNS_COLUNA };
+
+static int runs_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(valor," \
+    " comprimento INTEGER, inicio INTEGER, fim INTEGER, coluna HIDDEN)");
+}
+
+static int runs_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  return indexa_argumentos(info, RUNS_COLUNA, 1, 1);
+}
+
+static int runs_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  runs_cursor *c = (runs_cursor *) sqlite3_malloc(sizeof(runs_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(runs_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int runs_close(sqlite3_vtab_cursor *cur)
+{
+  runs_cursor *c = (runs_cursor *) cur;
+  sqlite3_finalize(c->stmt);
+  sqlite3_value_free(c->valor);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/*
+ * Compara os valores quanto à igualdade tal que NULLs são iguais entre si e
+ * valores numéricos são comparados independentemente de serem inteiros ou
+ * reais.
+*/
+static int valores_iguais(sqlite3_value *a, sqlite3_value *b)
+{
+  int ta = sqlite3_value_type(a), tb = sqlite3_value_type(b), n;
+
+  if ((ta == SQLITE_INTEGER || ta == SQLITE_FLOAT)
+      && (tb == SQLITE_INTEGER || tb == SQLITE_FLOAT)) {
+    if (ta == SQLITE_INTEGER && tb == SQLITE_INTEGER) {
+      return sqlite3_value_int64(a) == sqlite3_value_int64(b);
+    }
+    return sqlite3_value_double(a) == sqlite3_value_double(b);
+  }
+  if (ta != tb) return 0;
+  if (ta == SQLITE_NULL) return 1;
+  n = sqlite3_value_bytes(a);
+  return n == sqlite3_value_bytes(b)
+    && memcmp(sqlite3_value_blob(a), sqlite3_value_blob(b), n) == 0;
+}
+
+/* Avança o stmt registrando se está posicionado numa linha. */
+static int runs_avanca(runs_cursor *c)
+{
+  int r = sqlite3_step(c->stmt);
+  c->pendente = (r == SQLITE_ROW);
+  return (r == SQLITE_ROW || r == SQLITE_DONE) ? SQLITE_OK : r;
+}
+
+static int runs_next(sqlite3_vtab_cursor *cur)
+{
+  runs_cursor *c = (runs_cursor *) cur;
+  int r;
+
+  if (!c->pendente) {
+    c->eof = 1;
+    return SQLITE_OK;
+  }
+  sqlite3_value_free(c->valor);
+  if (!(c->valor = sqlite3_value_dup(sqlite3_column_value(c->stmt, 1)))) {
+    return SQLITE_NOMEM;
+  }
+  c->inicio = c->fim = sqlite3_column_int(c->stmt, 0);
+  c->comprimento = 0;
+  do {
+    c->fim = sqlite3_column_int(c->stmt, 0);
+    c->comprimento++;
+    if ((r = runs_avanca(c)) != SQLITE_OK) return r;
+  } while (c->pendente && valores_iguais(c->valor, sqlite3_column_value(c->stmt, 1)));
+  c->rowid++;
+  return SQLITE_OK;
+}
+
+static int runs_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  runs_cursor *c = (runs_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  const char *coluna = (const char *) sqlite3_value_text(argv[0]);
+  char *z;
+  int r;
+
+  sqlite3_finalize(c->stmt);
+  c->stmt = NULL;
+  if (!coluna) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("argumento não contém nome de coluna");
+    return SQLITE_ERROR;
+  }
+  z = sqlite3_mprintf("SELECT concurso, concursos.\"%w\" FROM concursos ORDER BY concurso", coluna);
+  if (!z) return SQLITE_NOMEM;
+  r = sqlite3_prepare_v2(v->db, z, -1, &c->stmt, NULL);
+  sqlite3_free(z);
+  if (r != SQLITE_OK) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("coluna \"%s\" não está disponível: %s",
+      coluna, sqlite3_errmsg(v->db));
+    return r;
+  }
+  c->eof = 0;
+  c->rowid = 0;
+  if ((r = runs_avanca(c)) != SQLITE_OK) return r;
+  return runs_next(cur);
+}
+
+static int runs_eof(sqlite3_vtab_cursor *cur)
+{
+  return ((runs_cursor *) cur)->eof;
+}
+
+static int runs_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  runs_cursor *c = (runs_cursor *) cur;
+
+  switch (k) {
+    case RUNS_VALOR:
+      sqlite3_result_value(ctx, c->valor);
+      break;
+    case RUNS_COMPRIMENTO:
+      sqlite3_result_int(ctx, c->comprimento);
+      break;
+    case RUNS_INICIO:
+      sqlite3_result_int(ctx, c->inicio);
+      break;
+    case RUNS_FIM:
+      sqlite3_result_int(ctx, c->fim);
+      break;
+    case RUNS_COLUNA:
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int runs_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((runs_cursor *) cur)->rowid;
+  return SQLITE_OK;
+}
+
+static sqlite3_module runs_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  runs_connect,
+  runs_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  runs_open,
+  runs_close,
+  runs_filter,
+  runs_next,
+  runs_eof,
+  runs_column,
+  runs_rowid,
+};
+
+/* parâmetros da função gama incompleta regularizada */
+#define GAMA_ITERACOES 500
+#define GAMA_EPSILON 1e-15
+#define GAMA_MINIMO 1e-300
+
+/*
+ * Função gama incompleta regularizada superior Q(a, x) = Γ(a, x) / Γ(a),
+ * calculada pela série de P(a, x) se x < a+1, senão pela fração contínua de
+ * Q(a, x) via algoritmo de Lentz.
+*/
+static double gama_q(double a, double x)
+{
+  double fator, soma, termo, b, c, d, h, an;
+  int j;
+
+  if (x <= 0) return 1.0;
+  fator = exp(-x + a * log(x) - lgamma(a));
+  if (x < a + 1) {
+    soma = termo = 1.0 / a;
+    for (j = 1; j < GAMA_ITERACOES; ++j) {
+      termo *= x / (a + j);
+      soma += termo;
+      if (fabs(termo) < fabs(soma) * GAMA_EPSILON) break;
+    }
+    return 1.0 - soma * fator;
+  }
+  b = x + 1 - a;
+  c = 1.0 / GAMA_MINIMO;
+  d = 1.0 / b;
+  h = d;
+  for (j = 1; j < GAMA_ITERACOES; ++j) {
+    an = -j * (j - a);
+    b += 2;
+    d = an * d + b;
+    if (fabs(d) < GAMA_MINIMO) d = GAMA_MINIMO;
+    c = b + an / c;
+    if (fabs(c) < GAMA_MINIMO) c = GAMA_MINIMO;
+    d = 1.0 / d;
+    h *= d * c;
+    if (fabs(d * c - 1) < GAMA_EPSILON) break;
+  }
+  return fator * h;
+}
+
+/* P(X ≥ x) para X com distribuição chi-quadrado com "gl" graus de liberdade */
+#define P_CHI2(x, gl) gama_q((gl) / 2.0, (x) / 2.0)
+
+/*
+ * TESTES emite os testes de hipóteses dos scripts R de verificação, i.e.; a
+ * estatística chi-quadrado, os graus de liberdade e o p-valor de cada teste,
+ * mais as frequências observadas em texto, calculados numa única passagem
+ * sobre o cache da série sem transferir os registros dos concursos:
+ *
+ *    frequencias               aderência das frequências das 60 dezenas
+ *    frequencias_grupos        aderência das frequências dos grupos de 10
+ *                              dezenas (1-10, 11-20, ..., 51-60)
+ *    paridade                  proporção de dezenas pares = 0.5 (pares, ímpares)
+ *    sequencias                proporção de concursos com dezenas consecutivas
+ *                              = 0.4 (sim, não)
+ *    reincidentes              proporção de concursos com dezenas do concurso
+ *                              anterior = 0.5 (sim, não)
+ *    acumulados_sequencias     independência entre acumular e sortear dezenas
+ *                              consecutivas (tabela 2x2 acumulado x evento)
+ *    acumulados_reincidentes   independência entre acumular e reincidência de
+ *                              dezenas (tabela 2x2 acumulado x evento)
+ *    acumulados_paridade       independência entre acumular e a quantidade de
+ *                              dezenas pares, cujas frequências observadas
+ *                              formam a tabela 7x2 (0..6 pares x acumulado),
+ *                              testada com as linhas 0-1 e 5-6 combinadas
+ *
+ * Os testes de proporção são equivalentes ao prop.test do R sem correção de
+ * continuidade e as tabelas 2x2 são testadas também sem correção.
+ *
+ *    SELECT teste, estatistica, gl, p_valor FROM testes;
+*/
+#define PROPORCAO_PARIDADE     0.5
+#define PROPORCAO_SEQUENCIAS   0.4
+#define PROPORCAO_REINCIDENTES 0.5
+
+enum { TESTE_FREQUENCIAS, TESTE_FREQUENCIAS_GRUPOS, TESTE_PARIDADE,
+       TESTE_SEQUENCIAS, TESTE_REINCIDENTES, TESTE_ACUMULADOS_SEQUENCIAS,
+       TESTE_ACUMULADOS_REINCIDENTES, TESTE_ACUMULADOS_PARIDADE, N_TESTES };
+
+static const char *TESTES_NOMES[N_TESTES] = {
+  "frequencias", "frequencias_grupos", "paridade", "sequencias",
+  "reincidentes", "acumulados_sequencias", "acumulados_reincidentes",
+  "acumulados_paridade"
+};
+
+typedef struct teste_s
+{
+  double estatistica;
+  int gl;
+  double p;
+  char *observados;       /* frequências observadas separadas por espaço */
+}
+teste_t;
+
+typedef struct testes_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  int i;                  /* índice do teste corrente */
+  teste_t teste[N_TESTES];
+}
+testes_cursor;
+
+enum { TESTES_TESTE, TESTES_ESTATISTICA, TESTES_GL, TESTES_P_VALOR,
+       TESTES_OBSERVADOS };
+
+static int testes_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(teste TEXT," \
+    " estatistica REAL, gl INTEGER, p_valor REAL, observados TEXT)");
+}
+
+static int testes_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  info->estimatedCost = 10;
+  info->estimatedRows = N_TESTES;
+  return SQLITE_OK;
+}
+
+static int testes_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  testes_cursor *c = (testes_cursor *) sqlite3_malloc(sizeof(testes_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(testes_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static void testes_libera(testes_cursor *c)
+{
+  int j;
+  for (j = 0; j < N_TESTES; ++j) {
+    sqlite3_free(c->teste[j].observados);
+    c->teste[j].observados = NULL;
+  }
+}
+
+static int testes_close(sqlite3_vtab_cursor *cur)
+{
+  testes_libera((testes_cursor *) cur);
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+/* Registra as frequências observadas do teste como texto. */
+static int teste_observados(teste_t *t, const int *obs, int n)
+{
+  sqlite3_str *str = sqlite3_str_new(NULL);
+  int j;
+  for (j = 0; j < n; ++j) sqlite3_str_appendf(str, j ? " %d" : "%d", obs[j]);
+  t->observados = sqlite3_str_finish(str);
+  return t->observados ? SQLITE_OK : SQLITE_NOMEM;
+}
+
+/* Teste de aderência das frequências observadas à distribuição uniforme. */
+static void teste_aderencia(teste_t *t, const int *obs, int n)
+{
+  double total = 0, e;
+  int j;
+  for (j = 0; j < n; ++j) total += obs[j];
+  e = total / n;
+  t->estatistica = 0;
+  for (j = 0; j < n; ++j) t->estatistica += (obs[j] - e) * (obs[j] - e) / e;
+  t->gl = n - 1;
+  t->p = P_CHI2(t->estatistica, t->gl);
+}
+
+/* Teste da proporção de sucessos "obs[0]" em obs[0]+obs[1] igual a "p0". */
+static void teste_proporcao(teste_t *t, const int *obs, double p0)
+{
+  double n = obs[0] + obs[1], d = obs[0] - n * p0;
+  t->estatistica = d * d / (n * p0 * (1 - p0));
+  t->gl = 1;
+  t->p = P_CHI2(t->estatistica, t->gl);
+}
+
+/* Teste de independência da tabela de contingência em ordem de linhas. */
+static void teste_independencia(teste_t *t, const int *obs, int linhas, int colunas)
+{
+  double soma_linha[8] = { 0 }, soma_coluna[8] = { 0 }, total = 0, e;
+  int i, j;
+
+  for (i = 0; i < linhas; ++i) {
+    for (j = 0; j < colunas; ++j) {
+      soma_linha[i] += obs[i * colunas + j];
+      soma_coluna[j] += obs[i * colunas + j];
+      total += obs[i * colunas + j];
+    }
+  }
+  t->estatistica = 0;
+  for (i = 0; i < linhas; ++i) {
+    for (j = 0; j < colunas; ++j) {
+      e = soma_linha[i] * soma_coluna[j] / total;
+      if (e > 0) t->estatistica += (obs[i * colunas + j] - e) * (obs[i * colunas + j] - e) / e;
+    }
+  }
+  t->gl = (linhas - 1) * (colunas - 1);
+  t->p = P_CHI2(t->estatistica, t->gl);
+}
+
+static int testes_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  testes_cursor *c = (testes_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  serie_t *s = v->serie;
+  int freq[N_DEZENAS] = { 0 }, grupos[N_DEZENAS / 10] = { 0 }, paridade[2] = { 0 };
+  int seq[2] = { 0 }, reinc[2] = { 0 }, acc_seq[4] = { 0 }, acc_reinc[4] = { 0 };
+  int acc_par[14] = { 0 }, par[10];
+  int i, d, pares, sequenciado, reincidente, anterior, r;
+  u64 mask;
+
+  if ((r = serie_vtab_carrega(v)) != SQLITE_OK) return r;
+  testes_libera(c);
+
+  for (i = 0; i < s->n; ++i) {
+    mask = s->dezenas[i];
+    pares = 0;
+    while (mask) {
+      d = __builtin_ctzll(mask);
+      freq[d]++;
+      grupos[d / 10]++;
+      pares += d & 1;     /* bit d corresponde à dezena d+1 */
+      mask &= mask - 1;
+    }
+    mask = s->dezenas[i];
+    sequenciado = (mask & (mask >> 1)) != 0;
+    anterior = i > 0 && s->concurso[i-1] == s->concurso[i] - 1;
+    reincidente = anterior && (mask & s->dezenas[i-1]) != 0;
+
+    paridade[0] += pares;
+    paridade[1] += 6 - pares;
+    seq[!sequenciado]++;
+    if (anterior) reinc[!reincidente]++;
+    acc_seq[!s->acumulado[i] * 2 + !sequenciado]++;
+    acc_reinc[!s->acumulado[i] * 2 + !reincidente]++;
+    if (pares <= 6) acc_par[pares * 2 + !s->acumulado[i]]++;
+  }
+
+  teste_aderencia(c->teste + TESTE_FREQUENCIAS, freq, N_DEZENAS);
+  teste_aderencia(c->teste + TESTE_FREQUENCIAS_GRUPOS, grupos, N_DEZENAS / 10);
+  teste_proporcao(c->teste + TESTE_PARIDADE, paridade, PROPORCAO_PARIDADE);
+  teste_proporcao(c->teste + TESTE_SEQUENCIAS, seq, PROPORCAO_SEQUENCIAS);
+  teste_proporcao(c->teste + TESTE_REINCIDENTES, reinc, PROPORCAO_REINCIDENTES);
+  teste_independencia(c->teste + TESTE_ACUMULADOS_SEQUENCIAS, acc_seq, 2, 2);
+  teste_independencia(c->teste + TESTE_ACUMULADOS_REINCIDENTES, acc_reinc, 2, 2);
+  /* combina as linhas de baixas frequências: 0-1 e 5-6 dezenas pares */
+  par[0] = acc_par[0] + acc_par[2];
+  par[1] = acc_par[1] + acc_par[3];
+  memcpy(par + 2, acc_par + 4, 6 * sizeof(int));
+  par[8] = acc_par[10] + acc_par[12];
+  par[9] = acc_par[11] + acc_par[13];
+  teste_independencia(c->teste + TESTE_ACUMULADOS_PARIDADE, par, 5, 2);
+
+  if (teste_observados(c->teste + TESTE_FREQUENCIAS, freq, N_DEZENAS)
+      || teste_observados(c->teste + TESTE_FREQUENCIAS_GRUPOS, grupos, N_DEZENAS / 10)
+      || teste_observados(c->teste + TESTE_PARIDADE, paridade, 2)
+      || teste_observados(c->teste + TESTE_SEQUENCIAS, seq, 2)
+      || teste_observados(c->teste + TESTE_REINCIDENTES, reinc, 2)
+      || teste_observados(c->teste + TESTE_ACUMULADOS_SEQUENCIAS, acc_seq, 4)
+      || teste_observados(c->teste + TESTE_ACUMULADOS_REINCIDENTES, acc_reinc, 4)
+      || teste_observados(c->teste + TESTE_ACUMULADOS_PARIDADE, acc_par, 14)) {
+    return SQLITE_NOMEM;
+  }
+  c->i = 0;
+  return SQLITE_OK;
+}
+
+static int testes_next(sqlite3_vtab_cursor *cur)
+{
+  ((testes_cursor *) cur)->i++;
+  return SQLITE_OK;
+}
+
+static int testes_eof(sqlite3_vtab_cursor *cur)
+{
+  return ((testes_cursor *) cur)->i >= N_TESTES;
+}
+
+static int testes_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  testes_cursor *c = (testes_cursor *) cur;
+  teste_t *t = c->teste + c->i;
+
+  switch (k) {
+    case TESTES_TESTE:
+      sqlite3_result_text(ctx, TESTES_NOMES[c->i], -1, SQLITE_STATIC);
+      break;
+    case TESTES_ESTATISTICA:
+      sqlite3_result_double(ctx, t->estatistica);
+      break;
+    case TESTES_GL:
+      sqlite3_result_int(ctx, t->gl);
+      break;
+    case TESTES_P_VALOR:
+      sqlite3_result_double(ctx, t->p);
+      break;
+    case TESTES_OBSERVADOS:
+      sqlite3_result_text(ctx, t->observados, -1, SQLITE_TRANSIENT);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int testes_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((testes_cursor *) cur)->i + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module testes_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  testes_connect,
+  testes_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  testes_open,
+  testes_close,
+  testes_filter,
+  testes_next,
+  testes_eof,
+  testes_column,
+  testes_rowid,
+};
+
+/*
+ * Regiões do boleto, que dispõe as dezenas em 6 linhas de 10 colunas, como
+ * máscaras de 60 bits compatíveis com "dezenas_juntadas", tal que a contagem
+ * das dezenas sorteadas numa região é a contagem de bits da interseção:
+ *
+ *    linhas         6 linhas do boleto, de cima para baixo
+ *    colunas        10 colunas do boleto, da esquerda para a direita
+ *    quadrantes     15 blocos de 2x2 dezenas na ordem da função QUADRANTE
+ *                   da extensão "more-functions" i.e.; 11..15, 21..25, 31..35
+ *    diagonais      15 diagonais descendentes, de (linha 6, coluna 1) até
+ *                   (linha 1, coluna 10)
+ *    antidiagonais  15 diagonais ascendentes, de (linha 1, coluna 1) até
+ *                   (linha 6, coluna 10)
+*/
+#define LINHA(r)        (0x3FFULL << (10 * (r)))
+#define COLUNA(c)       (0x0004010040100401ULL << (c))
+#define QUADRANTE(q)    (0xC03ULL << (20 * ((q) / 5) + 2 * ((q) % 5)))
+
+static const u64 LINHAS[] = {
+  LINHA(0), LINHA(1), LINHA(2), LINHA(3), LINHA(4), LINHA(5)
+};
+
+static const u64 COLUNAS[] = {
+  COLUNA(0), COLUNA(1), COLUNA(2), COLUNA(3), COLUNA(4),
+  COLUNA(5), COLUNA(6), COLUNA(7), COLUNA(8), COLUNA(9)
+};
+
+static const u64 QUADRANTES[] = {
+  QUADRANTE(0), QUADRANTE(1), QUADRANTE(2), QUADRANTE(3), QUADRANTE(4),
+  QUADRANTE(5), QUADRANTE(6), QUADRANTE(7), QUADRANTE(8), QUADRANTE(9),
+  QUADRANTE(10), QUADRANTE(11), QUADRANTE(12), QUADRANTE(13), QUADRANTE(14)
+};
+
+/* células (r, c) com c-r constante, de -5 a 9 */
+static const u64 DIAGONAIS[] = {
+  0x0004000000000000ULL, 0x0008010000000000ULL, 0x0010020040000000ULL,
+  0x0020040080100000ULL, 0x0040080100200400ULL, 0x0080100200400801ULL,
+  0x0100200400801002ULL, 0x0200400801002004ULL, 0x0400801002004008ULL,
+  0x0801002004008010ULL, 0x0002004008010020ULL, 0x0000008010020040ULL,
+  0x0000000020040080ULL, 0x0000000000080100ULL, 0x0000000000000200ULL
+};
+
+/* células (r, c) com c+r constante, de 0 a 14 */
+static const u64 ANTIDIAGONAIS[] = {
+  0x0000000000000001ULL, 0x0000000000000402ULL, 0x0000000000100804ULL,
+  0x0000000040201008ULL, 0x0000010080402010ULL, 0x0004020100804020ULL,
+  0x0008040201008040ULL, 0x0010080402010080ULL, 0x0020100804020100ULL,
+  0x0040201008040200ULL, 0x0080402010080000ULL, 0x0100804020000000ULL,
+  0x0201008000000000ULL, 0x0402000000000000ULL, 0x0800000000000000ULL
+};
+
+#define N_ITENS(a) ((int) (sizeof(a) / sizeof((a)[0])))
+
+typedef struct regiao_s
+{
+  const char *nome;
+  const u64 *mascaras;
+  int n;
+}
+regiao_t;
+
+static const regiao_t REGIOES[] = {
+  { "linhas",        LINHAS,        N_ITENS(LINHAS) },
+  { "colunas",       COLUNAS,       N_ITENS(COLUNAS) },
+  { "quadrantes",    QUADRANTES,    N_ITENS(QUADRANTES) },
+  { "diagonais",     DIAGONAIS,     N_ITENS(DIAGONAIS) },
+  { "antidiagonais", ANTIDIAGONAIS, N_ITENS(ANTIDIAGONAIS) },
+};
+
+#define MAX_REGIOES 15    /* quantidade máxima de regiões de um tipo */
+
+/* Pesquisa o tipo de região pelo nome, sem distinção de caixa. */
+static const regiao_t *pesquisa_regiao(sqlite3_value *v)
+{
+  const char *z = (const char *) sqlite3_value_text(v);
+  int j;
+  if (z) {
+    for (j = 0; j < N_ITENS(REGIOES); ++j) {
+      if (sqlite3_stricmp(z, REGIOES[j].nome) == 0) return REGIOES + j;
+    }
+  }
+  return NULL;
+}
+
+/* Contagens das dezenas da máscara em cada região do tipo. */
+static KERNEL_POPCNT void conta_regioes(const regiao_t *g, u64 mask, int *contagem)
+{
+  int k;
+  for (k = 0; k < g->n; ++k) contagem[k] = __builtin_popcountll(mask & g->mascaras[k]);
+}
+
+/*
+ * REGIAO(tipo, k) retorna a máscara da k-ésima região do tipo, contada a
+ * partir de 1, para interseção com as máscaras de "dezenas_juntadas".
+ *
+ *    SELECT concurso FROM dezenas_juntadas WHERE dezenas & regiao('linhas', 1) == 0;
+*/
+static void regiao(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  const regiao_t *g = pesquisa_regiao(argv[0]);
+  int k;
+
+  if (!g) {
+    sqlite3_result_error(ctx, "tipo de região é desconhecido", -1);
+    return ;
+  }
+  k = sqlite3_value_int(argv[1]);
+  if (SQLITE_INTEGER != sqlite3_value_numeric_type(argv[1]) || k < 1 || k > g->n) {
+    sqlite3_result_error(ctx, "índice da região fora do intervalo", -1);
+    return ;
+  }
+  sqlite3_result_int64(ctx, (sqlite3_int64) g->mascaras[k-1]);
+}
+
+/*
+ * ASSINATURA(dezenas [, tipo]) retorna as quantidades de dezenas da máscara
+ * em cada região do tipo separadas por espaço, ou na ausência do tipo, a
+ * assinatura espacial completa: as contagens por linha, por coluna e por
+ * quadrante separadas por "|".
+ *
+ *    SELECT concurso, assinatura(dezenas) FROM dezenas_juntadas;
+*/
+static void assinatura(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  static const regiao_t *COMPLETA[] = { REGIOES, REGIOES + 1, REGIOES + 2 };
+  const regiao_t *g;
+  sqlite3_str *str;
+  int contagem[MAX_REGIOES], j, k, n;
+  u64 mask;
+
+  if (SQLITE_NULL == sqlite3_value_type(argv[0])) return ;
+  if (SQLITE_INTEGER != sqlite3_value_numeric_type(argv[0])) {
+    sqlite3_result_error(ctx, "argumento não é do tipo inteiro", -1);
+    return ;
+  }
+  mask = (u64) sqlite3_value_int64(argv[0]);
+  g = argc > 1 ? pesquisa_regiao(argv[1]) : COMPLETA[0];
+  if (!g) {
+    sqlite3_result_error(ctx, "tipo de região é desconhecido", -1);
+    return ;
+  }
+  n = argc > 1 ? 1 : N_ITENS(COMPLETA);
+
+  str = sqlite3_str_new(sqlite3_context_db_handle(ctx));
+  for (j = 0; j < n; ++j) {
+    if (argc == 1) g = COMPLETA[j];
+    conta_regioes(g, mask, contagem);
+    if (j) sqlite3_str_appendchar(str, 1, '|');
+    for (k = 0; k < g->n; ++k) sqlite3_str_appendf(str, k ? " %d" : "%d", contagem[k]);
+  }
+  if (sqlite3_str_errcode(str) != SQLITE_OK) {
+    sqlite3_free(sqlite3_str_finish(str));
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+  n = sqlite3_str_length(str);
+  sqlite3_result_text(ctx, sqlite3_str_finish(str), n, sqlite3_free);
+}
+
+/*
+ * DISTRIBUICAO_ESPACIAL(tipo) emite os histogramas das quantidades de dezenas
+ * sorteadas em cada região do tipo sobre todos os concursos, calculados numa
+ * única passagem pela série: para cada região e cada quantidade de 0 a 6, a
+ * quantidade de concursos em que a região recebeu exatamente essa quantidade
+ * de dezenas.
+ *
+ *    SELECT regiao, quantidade, concursos FROM distribuicao_espacial('quadrantes')
+ *      WHERE quantidade >= 3;
+*/
+typedef struct espacial_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  const regiao_t *g;      /* tipo das regiões */
+  int i;                  /* índice da linha corrente: regiao * 7 + quantidade */
+  int histograma[MAX_REGIOES][7];
+}
+espacial_cursor;
+
+enum { ESPACIAL_REGIAO, ESPACIAL_QUANTIDADE, ESPACIAL_CONCURSOS, ESPACIAL_MASCARA,
+       ESPACIAL_TIPO };
+
+static int espacial_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(regiao INTEGER," \
+    " quantidade INTEGER, concursos INTEGER, mascara INTEGER, tipo HIDDEN)");
+}
+
+static int espacial_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  return indexa_argumentos(info, ESPACIAL_TIPO, 1, 1);
+}
+
+static int espacial_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  espacial_cursor *c = (espacial_cursor *) sqlite3_malloc(sizeof(espacial_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(espacial_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int espacial_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  espacial_cursor *c = (espacial_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  serie_t *s = v->serie;
+  int contagem[MAX_REGIOES], i, k, r;
+
+  if (!(c->g = pesquisa_regiao(argv[0]))) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("tipo de região é desconhecido");
+    return SQLITE_ERROR;
+  }
+  if ((r = serie_vtab_carrega(v)) != SQLITE_OK) return r;
+  memset(c->histograma, 0, sizeof(c->histograma));
+  for (i = 0; i < s->n; ++i) {
+    conta_regioes(c->g, s->dezenas[i], contagem);
+    for (k = 0; k < c->g->n; ++k) c->histograma[k][contagem[k]]++;
+  }
+  c->i = 0;
+  return SQLITE_OK;
+}
+
+static int espacial_next(sqlite3_vtab_cursor *cur)
+{
+  ((espacial_cursor *) cur)->i++;
+  return SQLITE_OK;
+}
+
+static int espacial_eof(sqlite3_vtab_cursor *cur)
+{
+  espacial_cursor *c = (espacial_cursor *) cur;
+  return c->i >= c->g->n * 7;
+}
+
+static int espacial_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  espacial_cursor *c = (espacial_cursor *) cur;
+
+  switch (k) {
+    case ESPACIAL_REGIAO:
+      sqlite3_result_int(ctx, c->i / 7 + 1);
+      break;
+    case ESPACIAL_QUANTIDADE:
+      sqlite3_result_int(ctx, c->i % 7);
+      break;
+    case ESPACIAL_CONCURSOS:
+      sqlite3_result_int(ctx, c->histograma[c->i / 7][c->i % 7]);
+      break;
+    case ESPACIAL_MASCARA:
+      sqlite3_result_int64(ctx, (sqlite3_int64) c->g->mascaras[c->i / 7]);
+      break;
+    case ESPACIAL_TIPO:
+      sqlite3_result_text(ctx, c->g->nome, -1, SQLITE_STATIC);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int espacial_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((espacial_cursor *) cur)->i + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module espacial_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  espacial_connect,
+  espacial_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  espacial_open,
+  janela_close,
+  espacial_filter,
+  espacial_next,
+  espacial_eof,
+  espacial_column,
+  espacial_rowid,
+};
+
+/*
+ * TRANSICOES(k) emite as contagens das transições entre dezenas nos concursos
+ * separados por até "k" concursos: para cada defasagem "lag" de 1 a k e cada
+ * par de dezenas (origem, destino), a quantidade de concursos t em que a
+ * origem foi sorteada e o destino foi sorteado no concurso t+lag, junto com
+ * a quantidade de ocorrências da origem em concursos t cujo concurso t+lag
+ * existe, i.e.; o denominador da frequência condicional.
+ *
+ * O tensor 60×60×k é acumulado em blocos de TRANSICOES_BLOCO defasagens,
+ * dimensionados para que o bloco do tensor permaneça no cache de dados L1, e
+ * cada bloco custa uma passagem pela série, i.e.; o cálculo custa k/2
+ * passagens pela série. Restrições de igualdade sobre "lag" e "origem" limitam
+ * o cálculo às defasagens e dezenas requisitadas, tal que "lag" fixado custa
+ * uma única passagem.
+ *
+ *    SELECT destino, proporcao FROM transicoes(10) WHERE lag == 1 AND origem == 13
+ *      ORDER BY proporcao DESC;
+*/
+#define TRANSICOES_MAX_LAG 1000
+#define TRANSICOES_BLOCO 2    /* defasagens por bloco: 2 × 60 × 60 × 4 bytes */
+
+typedef struct transicoes_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  int k;                  /* defasagem máxima */
+  int lag0, nlags;        /* primeira defasagem e quantidade de defasagens */
+  int origem0, norigens;  /* índice da primeira origem e quantidade de origens */
+  int *contagem;          /* tensor [lag][origem][destino] */
+  int *ocorrencias;       /* matriz [lag][origem] */
+  int i;                  /* índice da linha corrente: (lag, origem, destino) */
+}
+transicoes_cursor;
+
+enum { TRANSICOES_LAG, TRANSICOES_ORIGEM, TRANSICOES_DESTINO, TRANSICOES_CONTAGEM,
+       TRANSICOES_OCORRENCIAS, TRANSICOES_PROPORCAO, TRANSICOES_K };
+
+/* bits de idxNum que indicam os argumentos de xFilter */
+#define TRANSICOES_ARG_K      1
+#define TRANSICOES_ARG_LAG    2
+#define TRANSICOES_ARG_ORIGEM 4
+
+static int transicoes_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(lag INTEGER," \
+    " origem INTEGER, destino INTEGER, contagem INTEGER, ocorrencias INTEGER," \
+    " proporcao REAL, k HIDDEN)");
+}
+
+/*
+ * O argumento "k" é obrigatório e as restrições de igualdade sobre "lag" e
+ * "origem" são repassadas a xFilter, nessa ordem, reduzindo o custo estimado.
+*/
+static int transicoes_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  static const int COLUNAS[] = { TRANSICOES_K, TRANSICOES_LAG, TRANSICOES_ORIGEM };
+  const struct sqlite3_index_constraint *c;
+  int argv[3], j, m, mask = 0;
+  double custo = 60.0 * 60.0 * 100.0;
+
+  for (j = 0, c = info->aConstraint; j < info->nConstraint; ++j, ++c) {
+    for (m = 0; m < 3 && c->iColumn != COLUNAS[m]; ++m) ;
+    if (m == 3) continue;
+    if (!c->usable) {
+      if (m == 0) return SQLITE_CONSTRAINT;
+      continue;
+    }
+    if (c->op != SQLITE_INDEX_CONSTRAINT_EQ || (mask & (1 << m))) continue;
+    mask |= 1 << m;
+    argv[m] = j;
+  }
+  if (!(mask & TRANSICOES_ARG_K)) {
+    info->estimatedCost = 1e99;
+    return SQLITE_CONSTRAINT;
+  }
+  for (j = 0, m = 0; m < 3; ++m) {
+    if (mask & (1 << m)) {
+      info->aConstraintUsage[argv[m]].argvIndex = ++j;
+      info->aConstraintUsage[argv[m]].omit = 1;
+    }
+  }
+  if (mask & TRANSICOES_ARG_LAG) custo /= 100.0;
+  if (mask & TRANSICOES_ARG_ORIGEM) custo /= 60.0;
+  info->idxNum = mask;
+  info->estimatedCost = custo;
+  info->estimatedRows = (sqlite3_int64) custo;
+  return SQLITE_OK;
+}
+
+static int transicoes_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  transicoes_cursor *c = (transicoes_cursor *) sqlite3_malloc(sizeof(transicoes_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(transicoes_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int transicoes_close(sqlite3_vtab_cursor *cur)
+{
+  transicoes_cursor *c = (transicoes_cursor *) cur;
+  sqlite3_free(c->contagem);
+  sqlite3_free(c->ocorrencias);
+  sqlite3_free(c);
+  return SQLITE_OK;
+}
+
+/*
+ * Acumula as transições das defasagens [a; b) da série, restritas às origens
+ * selecionadas pela máscara "origens".
+*/
+static void transicoes_acumula(transicoes_cursor *c, const serie_t *s, int a, int b, u64 origens)
+{
+  int i, j, l, lag, x, *linha;
+  u64 origem, mx, my;
+
+  for (i = 0; i < s->n; ++i) {
+    if (!(origem = s->dezenas[i] & origens)) continue;
+    for (lag = a; lag < b; ++lag) {
+      j = i + lag;
+      if (j >= s->n || s->concurso[j] != s->concurso[i] + lag) {
+        j = posicao_concurso(s, s->concurso[i] + lag);
+        if (j < 0) continue;
+      }
+      l = lag - c->lag0;
+      for (mx = origem; mx; mx &= mx - 1) {
+        x = __builtin_ctzll(mx) - c->origem0;
+        linha = c->contagem + ((size_t) l * c->norigens + x) * N_DEZENAS;
+        c->ocorrencias[l * c->norigens + x]++;
+        for (my = s->dezenas[j]; my; my &= my - 1) linha[__builtin_ctzll(my)]++;
+      }
+    }
+  }
+}
+
+static int transicoes_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  transicoes_cursor *c = (transicoes_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  u64 origens;
+  int j = 0, lag, r;
+
+  sqlite3_free(c->contagem);
+  sqlite3_free(c->ocorrencias);
+  c->contagem = c->ocorrencias = NULL;
+  c->i = 0;
+  c->nlags = 0;
+
+  if (SQLITE_INTEGER != sqlite3_value_numeric_type(argv[0])
+      || (c->k = sqlite3_value_int(argv[0])) < 1 || c->k > TRANSICOES_MAX_LAG) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("defasagem máxima fora do intervalo [1;%d]",
+      TRANSICOES_MAX_LAG);
+    return SQLITE_ERROR;
+  }
+  c->lag0 = 1;
+  c->nlags = c->k;
+  c->origem0 = 0;
+  c->norigens = N_DEZENAS;
+  if (idxNum & TRANSICOES_ARG_LAG) {
+    lag = sqlite3_value_int(argv[++j]);
+    c->lag0 = lag;
+    c->nlags = (SQLITE_INTEGER == sqlite3_value_numeric_type(argv[j])
+      && lag >= 1 && lag <= c->k) ? 1 : 0;
+  }
+  if (idxNum & TRANSICOES_ARG_ORIGEM) {
+    r = sqlite3_value_int(argv[++j]);
+    c->origem0 = r - 1;
+    c->norigens = 1;
+    if (SQLITE_INTEGER != sqlite3_value_numeric_type(argv[j]) || r < 1 || r > N_DEZENAS) {
+      c->nlags = 0;
+    }
+  }
+  if (c->nlags == 0) return SQLITE_OK;  /* nenhuma linha satisfaz as restrições */
+
+  if ((r = serie_vtab_carrega(v)) != SQLITE_OK) return r;
+  c->contagem = (int *) sqlite3_malloc64(
+    (sqlite3_uint64) c->nlags * c->norigens * N_DEZENAS * sizeof(int));
+  c->ocorrencias = (int *) sqlite3_malloc64(
+    (sqlite3_uint64) c->nlags * c->norigens * sizeof(int));
+  if (!c->contagem || !c->ocorrencias) return SQLITE_NOMEM;
+  memset(c->contagem, 0, (size_t) c->nlags * c->norigens * N_DEZENAS * sizeof(int));
+  memset(c->ocorrencias, 0, (size_t) c->nlags * c->norigens * sizeof(int));
+
+  origens = c->norigens == 1 ? 1ULL << c->origem0 : ~0ULL;
+  for (lag = c->lag0; lag < c->lag0 + c->nlags; lag += TRANSICOES_BLOCO) {
+    r = lag + TRANSICOES_BLOCO;
+    transicoes_acumula(c, v->serie, lag, r < c->lag0 + c->nlags ? r : c->lag0 + c->nlags, origens);
+  }
+  return SQLITE_OK;
+}
+
+static int transicoes_next(sqlite3_vtab_cursor *cur)
+{
+  ((transicoes_cursor *) cur)->i++;
+  return SQLITE_OK;
+}
+
+static int transicoes_eof(sqlite3_vtab_cursor *cur)
+{
+  transicoes_cursor *c = (transicoes_cursor *) cur;
+  return c->i >= c->nlags * c->norigens * N_DEZENAS;
+}
+
+static int transicoes_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  transicoes_cursor *c = (transicoes_cursor *) cur;
+  int linha = c->i / N_DEZENAS;   /* índice de (lag, origem) */
+  int n = c->ocorrencias[linha];
+
+  switch (k) {
+    case TRANSICOES_LAG:
+      sqlite3_result_int(ctx, c->lag0 + linha / c->norigens);
+      break;
+    case TRANSICOES_ORIGEM:
+      sqlite3_result_int(ctx, c->origem0 + linha % c->norigens + 1);
+      break;
+    case TRANSICOES_DESTINO:
+      sqlite3_result_int(ctx, c->i % N_DEZENAS + 1);
+      break;
+    case TRANSICOES_CONTAGEM:
+      sqlite3_result_int(ctx, c->contagem[c->i]);
+      break;
+    case TRANSICOES_OCORRENCIAS:
+      sqlite3_result_int(ctx, n);
+      break;
+    case TRANSICOES_PROPORCAO:
+      if (n > 0) sqlite3_result_double(ctx, c->contagem[c->i] / (double) n);
+      break;
+    case TRANSICOES_K:
+      sqlite3_result_int(ctx, c->k);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int transicoes_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((transicoes_cursor *) cur)->i + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module transicoes_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  transicoes_connect,
+  transicoes_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  transicoes_open,
+  transicoes_close,
+  transicoes_filter,
+  transicoes_next,
+  transicoes_eof,
+  transicoes_column,
+  transicoes_rowid,
+};
+
+/*
+ * SEMELHANTES(alvo [, minimo]) pesquisa os concursos cujas dezenas sorteadas
+ * têm ao menos "minimo" dezenas em comum com o alvo (padrão 1), emitindo a
+ * quantidade de dezenas em comum e a distância de Hamming entre as máscaras.
+ * O alvo é a máscara de 60 bits, tal qual em "dezenas_juntadas", se é do tipo
+ * inteiro, ou o texto com as dezenas separadas por espaços ou vírgulas.
+ *
+ * As contagens de bits são calculadas por blocos de máscaras contíguas do
+ * cache da série, num laço sem desvios que o compilador vetoriza quando o
+ * processador dispõe de instruções de contagem de bits.
+ *
+ *    SELECT concurso, comuns FROM semelhantes('4 8 15 16 23 42 51 60', 4);
+ *
+ *    SELECT concurso FROM semelhantes(mascara(2000)) WHERE distancia <= 2;
+*/
+#define SEMELHANTES_BLOCO 256   /* máscaras por bloco de contagens */
+
+typedef struct semelhantes_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  u64 alvo;               /* máscara das dezenas pesquisadas */
+  int minimo;             /* quantidade mínima de dezenas em comum */
+  int i;                  /* posição do concurso corrente na série */
+  int bloco;              /* posição do primeiro concurso do bloco */
+  unsigned char comuns[SEMELHANTES_BLOCO];
+}
+semelhantes_cursor;
+
+enum { SEMELHANTES_CONCURSO, SEMELHANTES_COMUNS, SEMELHANTES_DISTANCIA,
+       SEMELHANTES_DEZENAS, SEMELHANTES_ALVO, SEMELHANTES_MINIMO };
+
+static int semelhantes_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  return serie_connect_ddl(db, aux, ppVtab, err, "CREATE TABLE x(concurso INTEGER," \
+    " comuns INTEGER, distancia INTEGER, dezenas INTEGER, alvo HIDDEN, minimo HIDDEN)");
+}
+
+static int semelhantes_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  return indexa_argumentos(info, SEMELHANTES_ALVO, 2, 1);
+}
+
+static int semelhantes_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  semelhantes_cursor *c = (semelhantes_cursor *) sqlite3_malloc(sizeof(semelhantes_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(semelhantes_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+/*
+ * Converte o alvo informado como máscara ou como lista de dezenas, retornando
+ * zero se o alvo é inválido.
+*/
+static int semelhantes_alvo(sqlite3_value *v, u64 *alvo)
+{
+  const char *z;
+  char *fim;
+  long d;
+
+  if (SQLITE_INTEGER == sqlite3_value_type(v)) {
+    *alvo = (u64) sqlite3_value_int64(v);
+    return *alvo >> N_DEZENAS == 0;
+  }
+  if (SQLITE_TEXT != sqlite3_value_type(v)) return 0;
+  z = (const char *) sqlite3_value_text(v);
+  for (*alvo = 0; *z; z = fim) {
+    z += strspn(z, " ,\t");
+    if (!*z) break;
+    d = strtol(z, &fim, 10);
+    if (fim == z || d < 1 || d > N_DEZENAS) return 0;
+    *alvo |= 1ULL << (d - 1);
+  }
+  return 1;
+}
+
+/* Conta as dezenas em comum com o alvo no bloco que inicia na posição "i". */
+static KERNEL_POPCNT void semelhantes_conta(semelhantes_cursor *c, const serie_t *s, int i)
+{
+  const u64 *d = s->dezenas + i;
+  int j, n = s->n - i < SEMELHANTES_BLOCO ? s->n - i : SEMELHANTES_BLOCO;
+  for (j = 0; j < n; ++j) c->comuns[j] = (unsigned char) __builtin_popcountll(d[j] & c->alvo);
+  c->bloco = i;
+}
+
+/* Avança até o próximo concurso com a quantidade mínima de dezenas em comum. */
+static int semelhantes_next(sqlite3_vtab_cursor *cur)
+{
+  semelhantes_cursor *c = (semelhantes_cursor *) cur;
+  serie_t *s = ((serie_vtab *) cur->pVtab)->serie;
+
+  while (++c->i < s->n) {
+    if (c->i >= c->bloco + SEMELHANTES_BLOCO) semelhantes_conta(c, s, c->i);
+    if (c->comuns[c->i - c->bloco] >= c->minimo) break;
+  }
+  return SQLITE_OK;
+}
+
+static int semelhantes_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  semelhantes_cursor *c = (semelhantes_cursor *) cur;
+  serie_vtab *v = (serie_vtab *) cur->pVtab;
+  int r;
+
+  if (!semelhantes_alvo(argv[0], &c->alvo)) {
+    sqlite3_free(v->base.zErrMsg);
+    v->base.zErrMsg = sqlite3_mprintf("alvo não é máscara nem lista de dezenas");
+    return SQLITE_ERROR;
+  }
+  c->minimo = 1;
+  if (argc > 1) {
+    if (SQLITE_INTEGER != sqlite3_value_numeric_type(argv[1])) {
+      sqlite3_free(v->base.zErrMsg);
+      v->base.zErrMsg = sqlite3_mprintf("quantidade mínima não é do tipo inteiro");
+      return SQLITE_ERROR;
+    }
+    c->minimo = sqlite3_value_int(argv[1]);
+  }
+  if ((r = serie_vtab_carrega(v)) != SQLITE_OK) return r;
+  c->i = -1;
+  c->bloco = -SEMELHANTES_BLOCO;
+  return semelhantes_next(cur);
+}
+
+static int semelhantes_eof(sqlite3_vtab_cursor *cur)
+{
+  semelhantes_cursor *c = (semelhantes_cursor *) cur;
+  return c->i >= ((serie_vtab *) cur->pVtab)->serie->n;
+}
+
+static int semelhantes_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  semelhantes_cursor *c = (semelhantes_cursor *) cur;
+  serie_t *s = ((serie_vtab *) cur->pVtab)->serie;
+
+  switch (k) {
+    case SEMELHANTES_CONCURSO:
+      sqlite3_result_int(ctx, s->concurso[c->i]);
+      break;
+    case SEMELHANTES_COMUNS:
+      sqlite3_result_int(ctx, c->comuns[c->i - c->bloco]);
+      break;
+    case SEMELHANTES_DISTANCIA:
+      sqlite3_result_int(ctx, __builtin_popcountll(s->dezenas[c->i] ^ c->alvo));
+      break;
+    case SEMELHANTES_DEZENAS:
+      sqlite3_result_int64(ctx, (sqlite3_int64) s->dezenas[c->i]);
+      break;
+    case SEMELHANTES_ALVO:
+      sqlite3_result_int64(ctx, (sqlite3_int64) c->alvo);
+      break;
+    case SEMELHANTES_MINIMO:
+      sqlite3_result_int(ctx, c->minimo);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int semelhantes_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((semelhantes_cursor *) cur)->i + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module semelhantes_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  semelhantes_connect,
+  semelhantes_best_index,
+  serie_disconnect,
+  0,                  /* xDestroy */
+  semelhantes_open,
+  janela_close,
+  semelhantes_filter,
+  semelhantes_next,
+  semelhantes_eof,
+  semelhantes_column,
+  semelhantes_rowid,
+};
+
+#define PURE (SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS)
+
+/*
+ * Registra as funções da extensão compartilhando o cache da série alocado
+ * para a conexão, que é liberado quando a conexão é fechada.
+*/
+static int registra_funcoes(sqlite3 *db, serie_t **ps)
+{
+  serie_t *s = (serie_t *) sqlite3_malloc(sizeof(serie_t));
+  if (!s) return SQLITE_NOMEM;
+  memset(s, 0, sizeof(serie_t));
+
+  EXT_STATS_REGISTRA(db);
+  sqlite3_create_function_v2(db, "MASCARA", 1, SQLITE_UTF8, s, mascara, NULL, NULL, libera_serie);
+  sqlite3_create_function(db, "EXPORTA_SERIE", -1, SQLITE_UTF8 | SQLITE_DIRECTONLY, s, exporta_serie, NULL, NULL);
+  sqlite3_create_function(db, "IMPORTA_GANHADORES", -1, SQLITE_UTF8 | SQLITE_DIRECTONLY, s, importa_ganhadores, NULL, NULL);
+  sqlite3_create_function(db, "DIGEST", -1, PURE, NULL, digest, NULL, NULL);
+  sqlite3_create_function(db, "NORMALIZA", 1, PURE, NULL, normaliza, NULL, NULL);
+  sqlite3_create_function(db, "REGIAO", 2, PURE, NULL, regiao, NULL, NULL);
+  sqlite3_create_function(db, "ASSINATURA", 1, PURE, NULL, assinatura, NULL, NULL);
+  sqlite3_create_function(db, "ASSINATURA", 2, PURE, NULL, assinatura, NULL, NULL);
+  sqlite3_create_function(db, "DIGEST_AGG", -1, PURE, NULL, NULL, digest_agg_step, digest_agg_final);
+  sqlite3_create_function(db, "RENDER_BOLETO", 6, PURE, NULL, NULL, render_boleto_step, render_boleto_final);
+  sqlite3_create_function(db, "RENDER_BOLETO", 7, PURE, NULL, NULL, render_boleto_step, render_boleto_final);
+
+  sqlite3_create_module(db, "JANELA", &janela_module, s);
+  sqlite3_create_module(db, "EVOLUCAO", &evolucao_module, s);
+  sqlite3_create_module(db, "GANHADORES_XML", &ganhadores_xml_module, s);
+  sqlite3_create_module(db, "SORTEIOS_ENTRE", &sorteios_module, s);
+  sqlite3_create_module(db, "RUNS", &runs_module, s);
+  sqlite3_create_module(db, "TESTES", &testes_module, s);
+  sqlite3_create_module(db, "DISTRIBUICAO_ESPACIAL", &espacial_module, s);
+  sqlite3_create_module(db, "TRANSICOES", &transicoes_module, s);
+  sqlite3_create_module(db, "SEMELHANTES", &semelhantes_module, s);
+
+  if (ps) *ps = s;
+  return SQLITE_OK;
+}
+
+int sqlite3_concursos_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  SQLITE_EXTENSION_INIT2(api)
+
+  return registra_funcoes(db, NULL);
+}
+
+/*
+ * Ponto de entrada alternativo para conexões somente leitura de relatórios e
+ * scripts de análise, cujo db deve estar em WAL para que o escritor noturno
+ * não bloqueie os leitores e vice-versa.
+*/
+int sqlite3_serving_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  serie_t *s;
+  char *z;
+  int r;
+
+  SQLITE_EXTENSION_INIT2(api)
+
+  r = registra_funcoes(db, &s);
+  if (r != SQLITE_OK) return r;
+
+  z = sqlite3_mprintf("PRAGMA mmap_size = %d; PRAGMA query_only = ON;", MMAP_SIZE);
+  r = sqlite3_exec(db, z, NULL, NULL, err);
+  sqlite3_free(z);
+  if (r != SQLITE_OK) return r;
+
+  /* pré-carga do cache e das páginas das tabelas mais consultadas */
+  if (carrega_serie(db, s) == SQLITE_OK) {
+    sqlite3_exec(db, "SELECT max(dezena) FROM dezenas_sorteadas;" \
+      "SELECT max(dezenas) FROM dezenas_juntadas;" \
+      "SELECT max(cidade) FROM ganhadores;", NULL, NULL, NULL);
+  }
+
+  return SQLITE_OK;
+}
@@ -1,7 +1,7 @@
 /*
- * MD5 + funções criptográficas naives no SQLite:
+ * MD5, SHA256 + funções criptográficas naives no SQLite:
  *
- *    MD5, ENC, DEC, GET_CRYTP, SET_CRYPT
+ *    MD5, SHA256, MD5_AGG, SHA256_AGG, ENC, DEC, GET_CRYTP, SET_CRYPT
  *
  * Dependências:
  *
@@ -9,7 +9,11 @@
  *
  * Compilação:
  *
- *    gcc crypt.c -Wall -fPIC -shared -lm -lcrypto -o crypt.so
+ *    gcc crypt.c -Wall -O2 -fPIC -shared -lm -lcrypto -o crypt.so
+ *
+ * ou, para uso do processamento byte a byte em lugar do vetorial:
+ *
+ *    gcc crypt.c -Wall -O2 -fPIC -shared -lm -lcrypto -D CRYPT_ESCALAR -o crypt.so
  *
  * Uso em arquivos de inicialização ou sessões interativas:
  *
@@ -20,48 +24,165 @@
  *    select load_extension("path_to_lib/crypt.so");
 */
 #include <sqlite3ext.h>
+#ifdef EXTENSAO_UNIFICADA
+SQLITE_EXTENSION_INIT3
+#else
 SQLITE_EXTENSION_INIT1
+#endif
 
 #include <string.h>
 #include <stdlib.h>
-#include <openssl/md5.h>
+#include <openssl/evp.h>
+
+#define EXT_STATS_FONTE "crypt"
+#include "ext_stats.h"
 
 #if SQLITE_VERSION_NUMBER < 3007011
 #define sqlite3_stricmp(a, b) sqlite3_strnicmp((a), (b), strlen(a))
 #endif
 
+#ifndef SQLITE_DETERMINISTIC
+#define SQLITE_DETERMINISTIC 0
+#endif
+
+#ifndef SQLITE_INNOCUOUS
+#define SQLITE_INNOCUOUS 0
+#endif
+
+/*
+ * Retorna o digest como string de dígitos hexadecimais alocada via SQLite.
+*/
+static char *hexdigest(const unsigned char *digest, unsigned int n)
+{
+  static const char HEX[] = "0123456789abcdef";
+  char *rz;
+  unsigned int i;
+
+  rz = sqlite3_malloc((n << 1) + 1);
+  if (rz) {
+    for (i = 0; i < n; i++)
+    {
+      rz[i << 1] = HEX[digest[i] >> 4];
+      rz[(i << 1) + 1] = HEX[digest[i] & 15];
+    }
+    rz[n << 1] = 0;
+  }
+  return rz;
+}
+
 /*
- * Retorna o MD5 128-bit checksum do argumento como string de 32 dígitos
- * hexadecimais ou NULL se o argumento é NULL.
+ * Retorna o checksum do argumento como string de dígitos hexadecimais ou
+ * NULL se o argumento é NULL, usando o algoritmo vinculado à função:
+ *
+ *    MD5     128-bit checksum com 32 dígitos
+ *    SHA256  256-bit checksum com 64 dígitos
+ *
+ * O argumento é considerado como BLOB, portanto pode conter bytes nulos.
 */
-static void md5(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+static void digest(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  unsigned char digest[MD5_DIGEST_LENGTH];
-  unsigned char *z;
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned int n;
+  const void *z;
   char *rz;
-  int i;
 
   if (SQLITE_NULL == sqlite3_value_type(argv[0])) {
     sqlite3_result_null(ctx);
     return ;
   }
-  z = (unsigned char *) sqlite3_value_text(argv[0]);
+  z = sqlite3_value_blob(argv[0]);
+
+  if (!EVP_Digest(z, sqlite3_value_bytes(argv[0]), md, &n,
+      (const EVP_MD *) sqlite3_user_data(ctx), NULL)) {
+    sqlite3_result_error(ctx, "falha no cálculo do digest", -1);
+    return ;
+  }
 
-  rz = sqlite3_malloc((MD5_DIGEST_LENGTH << 1) + 1);
+  rz = hexdigest(md, n);
   if (!rz) {
     sqlite3_result_error_nomem(ctx);
     return ;
   }
+  sqlite3_result_text(ctx, rz, n << 1, sqlite3_free);
+}
 
-  MD5(z, strlen((char *) z), (unsigned char *) &digest);
+/*
+ * Estado das funções agregadas MD5_AGG e SHA256_AGG.
+*/
+typedef struct agregado_s
+{
+  EVP_MD_CTX *md;   // contexto iniciado no primeiro valor não NULL
+}
+agregado_t;
 
-  for (i = 0; i < MD5_DIGEST_LENGTH; i++)
-  {
-    sqlite3_snprintf(3, rz + (i << 1), "%02x", (unsigned int) digest[i]);
+/*
+ * Agrega os bytes do argumento, considerado como BLOB, ao digest incremental
+ * do grupo, ignorando NULLs, tal que o resultado é o checksum da concatenação
+ * dos valores na ordem em que são lidos, e.g. o checksum da tabela "concursos"
+ * usando "json_array" para delimitar os registros:
+ *
+ *    SELECT MD5_AGG(json_array(concurso, data_sorteio, ...))
+ *      FROM (SELECT * FROM concursos ORDER BY concurso);
+ *
+ * MD5_AGG(x) é equivalente a MD5(GROUP_CONCAT(x, '')) sem a concatenação.
+*/
+static void digest_step(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  agregado_t *a;
+  const void *z;
+
+  if (SQLITE_NULL == sqlite3_value_type(argv[0])) return;
+
+  a = (agregado_t *) sqlite3_aggregate_context(ctx, sizeof(agregado_t));
+  if (!a) {
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+
+  if (!a->md) {
+    a->md = EVP_MD_CTX_new();
+    if (!a->md) {
+      sqlite3_result_error_nomem(ctx);
+      return ;
+    }
+    if (!EVP_DigestInit_ex(a->md,
+        (const EVP_MD *) sqlite3_user_data(ctx), NULL)) {
+      EVP_MD_CTX_free(a->md);
+      a->md = NULL;
+      sqlite3_result_error(ctx, "falha no cálculo do digest", -1);
+      return ;
+    }
   }
 
-  sqlite3_result_text(ctx, rz, -1, SQLITE_TRANSIENT);
-  sqlite3_free(rz);
+  z = sqlite3_value_blob(argv[0]);
+  EVP_DigestUpdate(a->md, z, sqlite3_value_bytes(argv[0]));
+}
+
+/*
+ * Retorna o checksum agregado como string de dígitos hexadecimais ou NULL se
+ * o grupo não contém valores não NULL.
+*/
+static void digest_final(sqlite3_context *ctx)
+{
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned int n;
+  agregado_t *a;
+  char *rz;
+
+  a = (agregado_t *) sqlite3_aggregate_context(ctx, 0);
+  if (!a || !a->md) {
+    sqlite3_result_null(ctx);
+    return ;
+  }
+
+  if (!EVP_DigestFinal_ex(a->md, md, &n)) {
+    sqlite3_result_error(ctx, "falha no cálculo do digest", -1);
+  } else if ((rz = hexdigest(md, n)) == NULL) {
+    sqlite3_result_error_nomem(ctx);
+  } else {
+    sqlite3_result_text(ctx, rz, n << 1, sqlite3_free);
+  }
+  EVP_MD_CTX_free(a->md);
 }
 
 static unsigned char lrotate(unsigned char val, int n)
@@ -145,6 +266,82 @@ static char both_decifrar_char(char c, char k)
   return ROT(c ^ k, ROT(k, k));
 }
 
+/*
+ * Decomposição de cada método num "passo" por byte da chave, equivalente às
+ * funções acima, tal que o byte transformado é:
+ *
+ *    RROT(c ^ x1, r) ^ x2
+ *
+ * onde RROT é a rotação à direita de r bits, com 0 <= r < 8, permitindo que
+ * o texto seja processado em blocos com a sequência de passos pré-calculada.
+*/
+typedef struct passo_s
+{
+  unsigned char x1;   // xor aplicado antes da rotação
+  unsigned char r;    // quantidade de bits da rotação à direita
+  unsigned char x2;   // xor aplicado após a rotação
+}
+passo_t;
+
+// quantidade efetiva de bits rotacionados por ROT, que não rotaciona se o
+// argumento é negativo, e a rotação à direita equivalente a LROT
+#define AMOUNT(b)  (((int) (char) (b) >= 0) ? ((int) (char) (b)) % 8 : 0)
+
+#define LEFT(n)    ((8 - (n)) & 7)
+
+#define PASSO(p, a, b, c) \
+  do { (p)->x1 = (a); (p)->r = (b); (p)->x2 = (c); } while (0)
+
+static void naive_cifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, k, 0, 0);
+}
+
+static void usual_cifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, k, AMOUNT(k), 0);
+}
+
+static void usual_decifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, 0, LEFT(AMOUNT(k)), k);
+}
+
+static void single_cifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, 0, AMOUNT(k), k);
+}
+
+static void single_decifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, k, LEFT(AMOUNT(k)), 0);
+}
+
+static void alternate_cifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, k, (k % 2) ? LEFT(AMOUNT(k)) : AMOUNT(k), 0);
+}
+
+static void alternate_decifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, 0, (k % 2) ? AMOUNT(k) : LEFT(AMOUNT(k)), k);
+}
+
+static void twin_cifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, ROT(k, k), 0, 0);
+}
+
+static void both_cifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, 0, LEFT(AMOUNT(ROT(k, k))), k);
+}
+
+static void both_decifrar_passo(char k, passo_t *p)
+{
+  PASSO(p, k, AMOUNT(ROT(k, k)), 0);
+}
+
 static const char *METHODS[] = \
   { "naive", "usual", "single", "alternate", "twin", "both" };
 
@@ -155,14 +352,181 @@ typedef struct crypt_s
   char *method;
   char (*cifrar_char)(char c, char k);
   char (*decifrar_char)(char c, char k);
+  void (*cifrar_passo)(char k, passo_t *p);
+  void (*decifrar_passo)(char k, passo_t *p);
 }
 crypt_t;
 
-static crypt_t engine;  // var global iniciada com NULLs
+/*
+ * O engine de criptografia é individual por conexão, alocado na carga da
+ * extensão e compartilhado como "user data" pelas funções, portanto conexões
+ * distintas podem usar métodos distintos simultaneamente, inclusive em
+ * threads distintas no modo SQLITE_THREADSAFE=2.
+*/
+
+/*
+ * O processamento em blocos usa as extensões vetoriais do GCC, compiladas em
+ * instruções SSE2 ou AVX2 conforme o alvo da compilação, senão é mantido o
+ * processamento byte a byte, que também pode ser forçado com -D CRYPT_ESCALAR
+ * para verificação dos resultados. Se o alvo não inclui AVX2, ambas as versões
+ * são compiladas e a versão é selecionada na carga da biblioteca conforme a CPU.
+*/
+#if defined(__GNUC__) && !defined(CRYPT_ESCALAR)
+
+#define VETORIAL
+
+#if defined(__x86_64__) && !defined(__AVX2__)
+#define KERNEL_AVX2 __attribute__((target_clones("avx2", "default")))
+#else
+#define KERNEL_AVX2
+#endif
+
+#define BLOCO 32
+
+typedef unsigned char vetor_t __attribute__ ((vector_size (BLOCO)));
+
+/*
+ * Sequência de passos de um método aplicada à chave, armazenada como vetores
+ * de bytes de comprimento k + BLOCO, tal que o bloco do texto na posição j
+ * usa os bytes das sequências a partir da posição j % k.
+ *
+ * A rotação é decomposta em rotações condicionais de 1, 2 e 4 bits, cujas
+ * máscaras de seleção (0x00 ou 0xFF) também são pré-calculadas.
+*/
+typedef struct fluxo_s
+{
+  char *method;         // método usado no cálculo dos passos
+  int k;                // comprimento da chave
+  unsigned char *x1, *m1, *m2, *m4, *x2;
+  unsigned char dados[];
+}
+fluxo_t;
+
+static fluxo_t *expande_chave(const char *chave, int k, char *method,
+  void (*passo)(char k, passo_t *p))
+{
+  fluxo_t *f;
+  passo_t p;
+  int j, n = k + BLOCO;
+
+  f = sqlite3_malloc(sizeof(fluxo_t) + 5 * n);
+  if (!f) return NULL;
+  f->method = method;
+  f->k = k;
+  f->x1 = f->dados;
+  f->m1 = f->x1 + n;
+  f->m2 = f->m1 + n;
+  f->m4 = f->m2 + n;
+  f->x2 = f->m4 + n;
+
+  for (j = 0; j < k; ++j)
+  {
+    passo(chave[j], &p);
+    f->x1[j] = p.x1;
+    f->m1[j] = (p.r & 1) ? 0xFF : 0;
+    f->m2[j] = (p.r & 2) ? 0xFF : 0;
+    f->m4[j] = (p.r & 4) ? 0xFF : 0;
+    f->x2[j] = p.x2;
+  }
+  // repetição periódica da sequência para leitura de blocos sem "wrap"
+  for (; j < n; ++j)
+  {
+    f->x1[j] = f->x1[j-k];
+    f->m1[j] = f->m1[j-k];
+    f->m2[j] = f->m2[j-k];
+    f->m4[j] = f->m4[j-k];
+    f->x2[j] = f->x2[j-k];
+  }
+
+  return f;
+}
+
+#define VETOR(v, z) memcpy(&(v), (z), BLOCO)
+
+#define RROT(v, n, m) \
+  do { vetor_t t = ((v) >> (n)) | ((v) << (8 - (n))); \
+    (v) = (t & (m)) | ((v) & ~(m)); } while (0)
+
+/*
+ * Transforma in place os n bytes do buffer, com n múltiplo de BLOCO.
+*/
+static KERNEL_AVX2 void cifra_blocos(unsigned char *z, int n, const fluxo_t *f)
+{
+  vetor_t v, x1, m1, m2, m4, x2;
+  int j, o;
+
+  for (j = o = 0; j < n; j += BLOCO)
+  {
+    VETOR(v, z+j);
+    VETOR(x1, f->x1+o);
+    VETOR(m1, f->m1+o);
+    VETOR(m2, f->m2+o);
+    VETOR(m4, f->m4+o);
+    VETOR(x2, f->x2+o);
+    v ^= x1;
+    RROT(v, 1, m1);
+    RROT(v, 2, m2);
+    RROT(v, 4, m4);
+    v ^= x2;
+    memcpy(z+j, &v, BLOCO);
+    o = (o + BLOCO) % f->k;
+  }
+}
+
+#endif
+
+/*
+ * Configura o engine de criptografia de caracteres vinculando as funções do
+ * método que corresponde ao argumento, retornando zero se é desconhecido.
+*/
+static int bind_method(crypt_t *engine, const char *method)
+{
+  if (sqlite3_stricmp(method, "both") == 0) {
+    engine->method = "both";
+    engine->cifrar_char = both_cifrar_char;
+    engine->decifrar_char = both_decifrar_char;
+    engine->cifrar_passo = both_cifrar_passo;
+    engine->decifrar_passo = both_decifrar_passo;
+  } else if (sqlite3_stricmp(method, "twin") == 0) {
+    engine->method = "twin";
+    engine->cifrar_char = twin_cifrar_char;
+    engine->decifrar_char = twin_cifrar_char;
+    engine->cifrar_passo = twin_cifrar_passo;
+    engine->decifrar_passo = twin_cifrar_passo;
+  } else if (sqlite3_stricmp(method, "single") == 0) {
+    engine->method = "single";
+    engine->cifrar_char = single_cifrar_char;
+    engine->decifrar_char = single_decifrar_char;
+    engine->cifrar_passo = single_cifrar_passo;
+    engine->decifrar_passo = single_decifrar_passo;
+  } else if (sqlite3_stricmp(method, "usual") == 0) {
+    engine->method = "usual";
+    engine->cifrar_char = usual_cifrar_char;
+    engine->decifrar_char = usual_decifrar_char;
+    engine->cifrar_passo = usual_cifrar_passo;
+    engine->decifrar_passo = usual_decifrar_passo;
+  } else if (sqlite3_stricmp(method, "alternate") == 0) {
+    engine->method = "alternate";
+    engine->cifrar_char = alternate_cifrar_char;
+    engine->decifrar_char = alternate_decifrar_char;
+    engine->cifrar_passo = alternate_cifrar_passo;
+    engine->decifrar_passo = alternate_decifrar_passo;
+  } else if (sqlite3_stricmp(method, "naive") == 0) {
+    engine->method = "naive";
+    engine->cifrar_char = naive_cifrar_char;
+    engine->decifrar_char = naive_cifrar_char;
+    engine->cifrar_passo = naive_cifrar_passo;
+    engine->decifrar_passo = naive_cifrar_passo;
+  } else {
+    return 0;
+  }
+  return 1;
+}
 
 /*
  * Retorna texto cifrado usando criptografia por chave simétrica, tal que os
- * argumentos são a chave criptográfica e o texto.
+ * argumentos são a chave criptográfica, o texto e opcionalmente o nome do
+ * método, que se omitido ou NULL é o incumbente da conexão.
  *
  * ENC é a função inversa de DEC:
  *
@@ -170,11 +534,21 @@ static crypt_t engine;  // var global iniciada com NULLs
 */
 static void enc(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
+  crypt_t *engine = (crypt_t *) sqlite3_user_data(ctx), metodo;
   const char *chave, *texto;
   char *cifrado;
-  int j, k;
+  int n, k;
+
+  if ((argc == 3 || argc == -3)
+      && SQLITE_NULL != sqlite3_value_type(argv[2])) {
+    if (!bind_method(&metodo, (const char *) sqlite3_value_text(argv[2]))) {
+      sqlite3_result_error(ctx, "método é desconhecido", -1);
+      return ;
+    }
+    engine = &metodo;
+  }
 
-  if (!engine.method) {
+  if (!engine->method) {
     sqlite3_result_error(ctx, "método criptográfico não definido", -1);
     return ;
   }
@@ -184,7 +558,7 @@ static void enc(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     return ;
   }
   chave = (char *) sqlite3_value_text(argv[0]);
-  if (strlen(chave) == 0) {
+  if ((k = strlen(chave)) == 0) {
     sqlite3_result_error(ctx, "chave de comprimento zero", -1);
     return ;
   }
@@ -194,33 +568,65 @@ static void enc(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     return ;
   }
   texto = (char *) sqlite3_value_text(argv[1]);
+  n = strlen(texto);
+
+#ifdef VETORIAL
+{
+  // a sequência de passos é preservada entre as chamadas da requisição
+  // enquanto a chave for constante
+  fluxo_t *f = sqlite3_get_auxdata(ctx, 0);
+  int novo = !f || f->method != engine->method;
+  int m = (n + BLOCO - 1) / BLOCO * BLOCO;
+
+  if (novo) {
+    f = expande_chave(chave, k, engine->method,
+      (argc >= 0) ? engine->cifrar_passo : engine->decifrar_passo);
+    if (!f) {
+      sqlite3_result_error_nomem(ctx);
+      return ;
+    }
+  }
 
-  cifrado = sqlite3_malloc( strlen(texto) + 1 );
+  cifrado = sqlite3_malloc(m + 1);
   if (!cifrado) {
+    if (novo) sqlite3_free(f);
     sqlite3_result_error_nomem(ctx);
     return ;
   }
+  memcpy(cifrado, texto, n);
+  memset(cifrado + n, 0, m - n);
+  cifra_blocos((unsigned char *) cifrado, m, f);
 
-  if (argc >= 0) {
-    for (k = strlen(chave), j = 0; texto[j]; ++j)
-    {
-      cifrado[j] = engine.cifrar_char(texto[j], chave[j%k]);
-    }
-  } else {
-    for (k = strlen(chave), j = 0; texto[j]; ++j)
-    {
-      cifrado[j] = engine.decifrar_char(texto[j], chave[j%k]);
-    }
+  if (novo) sqlite3_set_auxdata(ctx, 0, f, sqlite3_free);
+}
+#else
+{
+  char (*cifrar_char)(char c, char k) =
+    (argc >= 0) ? engine->cifrar_char : engine->decifrar_char;
+  int i, j;
+
+  cifrado = sqlite3_malloc(n + 1);
+  if (!cifrado) {
+    sqlite3_result_error_nomem(ctx);
+    return ;
+  }
+  for (i = j = 0; j < n; ++j)
+  {
+    cifrado[j] = cifrar_char(texto[j], chave[i]);
+    if (++i == k) i = 0;
   }
-  cifrado[j] = 0;
+}
+#endif
+  cifrado[n] = 0;
 
-  sqlite3_result_text(ctx, cifrado, -1, SQLITE_TRANSIENT);
-  sqlite3_free(cifrado);
+  // o resultado é truncado no primeiro byte nulo eventualmente produzido
+  sqlite3_result_text(ctx, cifrado, -1, sqlite3_free);
 }
 
 /*
  * Retorna texto decifrado usando criptografia por chave simétrica, tal que os
- * argumentos são a chave criptográfica e o texto.
+ * argumentos são a chave criptográfica, o texto e opcionalmente o nome do
+ * método, que se omitido ou NULL é o incumbente da conexão.
  *
  * DEC é a função inversa de ENC:
  *
@@ -237,46 +643,15 @@ static void dec(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 */
 static void get_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  if (engine.method) {
-    sqlite3_result_text(ctx, engine.method, -1, SQLITE_TRANSIENT);
+  crypt_t *engine = (crypt_t *) sqlite3_user_data(ctx);
+
+  if (engine->method) {
+    sqlite3_result_text(ctx, engine->method, -1, SQLITE_TRANSIENT);
   } else {
     sqlite3_result_error(ctx, "método criptográfico não definido", -1);
   }
 }
 
-/*
- * Configura o engine de criptografia de caracteres vinculando as funções do
- * método que corresponde ao argumento.
-*/
-static void bind_method(const char *method)
-{
-  if (sqlite3_stricmp(method, "both") == 0) {
-    engine.method = "both";
-    engine.cifrar_char = both_cifrar_char;
-    engine.decifrar_char = both_decifrar_char;
-  } else if (sqlite3_stricmp(method, "twin") == 0) {
-    engine.method = "twin";
-    engine.cifrar_char = twin_cifrar_char;
-    engine.decifrar_char = twin_cifrar_char;
-  } else if (sqlite3_stricmp(method, "single") == 0) {
-    engine.method = "single";
-    engine.cifrar_char = single_cifrar_char;
-    engine.decifrar_char = single_decifrar_char;
-  } else if (sqlite3_stricmp(method, "usual") == 0) {
-    engine.method = "usual";
-    engine.cifrar_char = usual_cifrar_char;
-    engine.decifrar_char = usual_decifrar_char;
-  } else if (sqlite3_stricmp(method, "alternate") == 0) {
-    engine.method = "alternate";
-    engine.cifrar_char = alternate_cifrar_char;
-    engine.decifrar_char = alternate_decifrar_char;
-  } else if (sqlite3_stricmp(method, "naive") == 0) {
-    engine.method = "naive";
-    engine.cifrar_char = naive_cifrar_char;
-    engine.decifrar_char = naive_cifrar_char;
-  }
-}
-
 #define IS_SPACE(c) (((c) == 0x20) || (((c) >= 0x09) && ((c) <= 0x0D)))
 
 /*
@@ -313,6 +688,7 @@ static const char *trim(const char *src)
 */
 static void set_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
+  crypt_t *engine = (crypt_t *) sqlite3_user_data(ctx);
   char *s, *z = NULL;
   int j;
 
@@ -322,14 +698,14 @@ static void set_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
     s = (char *) trim((const char *) sqlite3_value_text(argv[0]));
     if (!s) {
       z ="o argumento é uma string vazia";
-    } else if (!engine.method || sqlite3_stricmp(s, engine.method)) {
+    } else if (!engine->method || sqlite3_stricmp(s, engine->method)) {
       // pesquisa a string no array de nomes de métodos
       for (j = 0; j < NUM_METHODS && sqlite3_stricmp(s, METHODS[j]); ++j) ;
       if (j == NUM_METHODS) {
         z = "método é desconhecido";
       } else {
         // vincula o método ao engine de criptografia
-        bind_method(s);
+        bind_method(engine, s);
 #if SQLITE_VERSION_NUMBER >= 3007013
 {
   // preserva o nome do método para uso persistente entre sessões
@@ -365,15 +741,30 @@ static void set_crypt(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   }
 }
 
-int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+#define PURE (SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS)
+
+int sqlite3_crypt_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
 {
-  SQLITE_EXTENSION_INIT2(api)
+  crypt_t *engine;
 
-  sqlite3_create_function(db, "MD5",  1, SQLITE_UTF8, NULL, md5, NULL, NULL);
-  sqlite3_create_function(db, "ENC",  2, SQLITE_UTF8, NULL, enc, NULL, NULL);
-  sqlite3_create_function(db, "DEC",  2, SQLITE_UTF8, NULL, dec, NULL, NULL);
-  sqlite3_create_function(db, "GET_CRYPT", 0, SQLITE_UTF8, NULL, get_crypt, NULL, NULL);
-  sqlite3_create_function(db, "SET_CRYPT", 1, SQLITE_UTF8, NULL, set_crypt, NULL, NULL);
+  SQLITE_EXTENSION_INIT2(api)
+  EXT_STATS_REGISTRA(db);
+
+  engine = (crypt_t *) sqlite3_malloc(sizeof(crypt_t));
+  if (!engine) return SQLITE_NOMEM;
+  memset(engine, 0, sizeof(crypt_t));
+
+  sqlite3_create_function(db, "MD5",  1, PURE, (void *) EVP_md5(), digest, NULL, NULL);
+  sqlite3_create_function(db, "SHA256", 1, PURE, (void *) EVP_sha256(), digest, NULL, NULL);
+  sqlite3_create_function(db, "MD5_AGG", 1, PURE, (void *) EVP_md5(), NULL, digest_step, digest_final);
+  sqlite3_create_function(db, "SHA256_AGG", 1, PURE, (void *) EVP_sha256(), NULL, digest_step, digest_final);
+  sqlite3_create_function(db, "ENC",  2, SQLITE_UTF8, engine, enc, NULL, NULL);
+  sqlite3_create_function(db, "ENC",  3, SQLITE_UTF8, engine, enc, NULL, NULL);
+  sqlite3_create_function(db, "DEC",  2, SQLITE_UTF8, engine, dec, NULL, NULL);
+  sqlite3_create_function(db, "DEC",  3, SQLITE_UTF8, engine, dec, NULL, NULL);
+  sqlite3_create_function(db, "GET_CRYPT", 0, SQLITE_UTF8, engine, get_crypt, NULL, NULL);
+  /* o engine é liberado quando a conexão é fechada */
+  sqlite3_create_function_v2(db, "SET_CRYPT", 1, SQLITE_UTF8, engine, set_crypt, NULL, NULL, sqlite3_free);
 
 #if SQLITE_VERSION_NUMBER >= 3007013
   {
@@ -382,7 +773,7 @@ int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *
 
     sqlite3_stmt *stmt;
     char *s, *z;
-    int n;
+    int n, obsoleta = 0;
 
     /* check-up do esquema da tabela PROPERTIES */
 
@@ -391,17 +782,20 @@ int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *
     if (SQLITE_ROW == sqlite3_step(stmt)) {
       for (s = (char *) sqlite3_column_text(stmt, 0); *s != '('; ++s) ;
       for (z = (char *) CREATE_TABLE; *z != '('; ++z) ;
-      if (sqlite3_strnicmp(s, z, strlen(s))) {
-        sqlite3_prepare_v2(db,
-          "DROP TABLE IF EXISTS properties;", -1, &stmt, NULL);
-        sqlite3_step(stmt);
-      }
+      obsoleta = sqlite3_strnicmp(s, z, strlen(s));
+    }
+    sqlite3_finalize(stmt);
+    if (obsoleta) {
+      sqlite3_prepare_v2(db, "DROP TABLE IF EXISTS properties;", -1, &stmt, NULL);
+      sqlite3_step(stmt);
+      sqlite3_finalize(stmt);
     }
 
     /* criação redundante da tabela */
 
     sqlite3_prepare_v2(db, CREATE_TABLE, -1, &stmt, NULL);
     sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
 
     /* configuração persistente do engine criptográfico */
 
@@ -413,7 +807,7 @@ int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *
       // pesquisa o valor no array de nomes de métodos
       for (n = 0; n < NUM_METHODS; ++n) {
         if (sqlite3_stricmp(s, METHODS[n]) == 0) {
-          bind_method(s);
+          bind_method(engine, s);
           break;
         }
       }
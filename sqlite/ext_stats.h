@@ -0,0 +1,542 @@
+/*
+ * Instrumentação opcional das funções SQL das extensões, habilitada somente
+ * na compilação com -DEXT_STATS, que registra por função a quantidade de
+ * chamadas, os tempos total e máximo das chamadas medidos via clock_gettime,
+ * os bytes requisitados via sqlite3_malloc/sqlite3_realloc e os acertos e
+ * faltas de sqlite3_get_auxdata, que é o cache das expressões regulares
+ * compiladas da extensão "regexp".
+ *
+ * Cada extensão define EXT_STATS_FONTE com seu nome e inclui este header
+ * após "sqlite3ext.h", então as funções registradas via
+ * sqlite3_create_function[_v2] são interpostas por versões medidas, sem
+ * modificação do código das funções, e EXT_STATS_REGISTRA(db) na função de
+ * inicialização registra a leitura das estatísticas:
+ *
+ *    SELECT * FROM ext_stats ORDER BY total_ms DESC;
+ *
+ *    SELECT ext_stats_reset();
+ *
+ * e o registro em stderr das declarações cuja execução excede o limite em
+ * milissegundos via sqlite3_trace_v2, onde zero desliga o registro:
+ *
+ *    SELECT ext_stats_lentas(50);
+ *
+ * O limite também pode ser informado na variável de ambiente EXT_STATS_LENTAS,
+ * aplicado na carga da extensão, tal que os scripts dos relatórios registram
+ * suas declarações lentas sem modificações:
+ *
+ *    EXT_STATS_LENTAS=20 ./monta
+ *
+ * A tabela virtual consulta as estatísticas de todas as extensões carregadas
+ * que foram compiladas com instrumentação. Sem -DEXT_STATS este header não
+ * tem efeito algum.
+*/
+#ifndef EXT_STATS_H
+#define EXT_STATS_H
+
+#ifdef EXT_STATS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef EXT_STATS_FONTE
+#error "EXT_STATS_FONTE deve ser definido com o nome da extensão"
+#endif
+
+#define EXT_STATS_NOME_FONTE "EXT_STATS_FONTE_" EXT_STATS_FONTE
+
+/* nomes das funções de leitura de todas as extensões instrumentáveis */
+static const char *EXT_STATS_FONTES[] = {
+  "more_functions", "regexp", "calendar", "crypt", "concursos"
+};
+
+typedef void (*ext_stats_xfunc)(sqlite3_context *, int, sqlite3_value **);
+typedef void (*ext_stats_xfinal)(sqlite3_context *);
+
+/* estatísticas da função, compartilhadas pelas conexões e nunca liberadas */
+typedef struct ext_stats_fn_s
+{
+  char nome[64];
+  int nargs;
+  sqlite3_int64 chamadas;
+  sqlite3_int64 total_ns;
+  sqlite3_int64 max_ns;
+  sqlite3_int64 bytes;
+  sqlite3_int64 acertos;
+  sqlite3_int64 faltas;
+  struct ext_stats_fn_s *prox;
+}
+ext_stats_fn;
+
+/* registro da função numa conexão, que é o "user data" efetivo */
+typedef struct ext_stats_reg_s
+{
+  ext_stats_fn *fn;
+  void *app;              /* "user data" original */
+  ext_stats_xfunc xFunc;
+  ext_stats_xfunc xStep;
+  ext_stats_xfinal xFinal;
+  void (*xDestroy)(void *);
+}
+ext_stats_reg;
+
+/* linha da tabela virtual, copiada das estatísticas de cada extensão */
+typedef struct ext_stats_linha_s
+{
+  const char *extensao;
+  ext_stats_fn fn;
+}
+ext_stats_linha;
+
+typedef struct ext_stats_coletor_s
+{
+  int n, capacidade;
+  ext_stats_linha *linhas;
+}
+ext_stats_coletor;
+
+static ext_stats_fn *ext_stats_lista;
+static __thread ext_stats_fn *ext_stats_corrente;
+
+/* interposições não usadas por todas as extensões */
+#define EXT_STATS_API static __attribute__((unused))
+
+#define EXT_STATS_SOMA(campo, v) __atomic_fetch_add(&(campo), (v), __ATOMIC_RELAXED)
+
+static sqlite3_int64 ext_stats_agora(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (sqlite3_int64) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void ext_stats_mede(ext_stats_fn *fn, sqlite3_int64 inicio)
+{
+  sqlite3_int64 ns = ext_stats_agora() - inicio, m;
+  EXT_STATS_SOMA(fn->chamadas, 1);
+  EXT_STATS_SOMA(fn->total_ns, ns);
+  m = __atomic_load_n(&fn->max_ns, __ATOMIC_RELAXED);
+  while (ns > m && !__atomic_compare_exchange_n(&fn->max_ns, &m, ns, 0,
+    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) ;
+}
+
+/*
+ * Interposições das funções registradas, que medem a chamada da função
+ * original tornando-a a função corrente da thread para atribuição das
+ * alocações e dos acessos ao cache de "auxdata".
+*/
+#define EXT_STATS_INTERPOE(chamada) \
+  ext_stats_reg *r = (ext_stats_reg *) sqlite3_user_data(ctx); \
+  ext_stats_fn *anterior = ext_stats_corrente; \
+  sqlite3_int64 inicio = ext_stats_agora(); \
+  ext_stats_corrente = r->fn; \
+  chamada; \
+  ext_stats_corrente = anterior; \
+  ext_stats_mede(r->fn, inicio)
+
+static void ext_stats_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  EXT_STATS_INTERPOE(r->xFunc(ctx, argc, argv));
+}
+
+static void ext_stats_step(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  EXT_STATS_INTERPOE(r->xStep(ctx, argc, argv));
+}
+
+static void ext_stats_final(sqlite3_context *ctx)
+{
+  EXT_STATS_INTERPOE(r->xFinal(ctx));
+}
+
+static void ext_stats_destroy(void *p)
+{
+  ext_stats_reg *r = (ext_stats_reg *) p;
+  if (r->xDestroy) r->xDestroy(r->app);
+  sqlite3_free(r);
+}
+
+/* Pesquisa ou cria as estatísticas da função (nome, nargs) da extensão. */
+static ext_stats_fn *ext_stats_pesquisa(const char *nome, int nargs)
+{
+  sqlite3_mutex *mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_APP1);
+  ext_stats_fn *fn;
+
+  sqlite3_mutex_enter(mutex);
+  for (fn = ext_stats_lista; fn; fn = fn->prox) {
+    if (fn->nargs == nargs && sqlite3_stricmp(fn->nome, nome) == 0) break;
+  }
+  if (!fn && (fn = (ext_stats_fn *) sqlite3_malloc(sizeof(ext_stats_fn)))) {
+    memset(fn, 0, sizeof(ext_stats_fn));
+    sqlite3_snprintf(sizeof(fn->nome), fn->nome, "%s", nome);
+    fn->nargs = nargs;
+    fn->prox = ext_stats_lista;
+    ext_stats_lista = fn;
+  }
+  sqlite3_mutex_leave(mutex);
+  return fn;
+}
+
+EXT_STATS_API int ext_stats_create_function_v2(sqlite3 *db, const char *nome, int nargs,
+  int rep, void *app, ext_stats_xfunc xFunc, ext_stats_xfunc xStep,
+  ext_stats_xfinal xFinal, void (*xDestroy)(void *))
+{
+  ext_stats_reg *r = (ext_stats_reg *) sqlite3_malloc(sizeof(ext_stats_reg));
+  if (!r || !(r->fn = ext_stats_pesquisa(nome, nargs))) {
+    sqlite3_free(r);
+    if (xDestroy) xDestroy(app);
+    return SQLITE_NOMEM;
+  }
+  r->app = app;
+  r->xFunc = xFunc;
+  r->xStep = xStep;
+  r->xFinal = xFinal;
+  r->xDestroy = xDestroy;
+  return sqlite3_create_function_v2(db, nome, nargs, rep, r,
+    xFunc ? ext_stats_func : NULL, xStep ? ext_stats_step : NULL,
+    xFinal ? ext_stats_final : NULL, ext_stats_destroy);
+}
+
+EXT_STATS_API int ext_stats_create_function(sqlite3 *db, const char *nome, int nargs,
+  int rep, void *app, ext_stats_xfunc xFunc, ext_stats_xfunc xStep,
+  ext_stats_xfinal xFinal)
+{
+  return ext_stats_create_function_v2(db, nome, nargs, rep, app, xFunc, xStep,
+    xFinal, NULL);
+}
+
+EXT_STATS_API void *ext_stats_user_data(sqlite3_context *ctx)
+{
+  return ((ext_stats_reg *) sqlite3_user_data(ctx))->app;
+}
+
+EXT_STATS_API void *ext_stats_get_auxdata(sqlite3_context *ctx, int n)
+{
+  void *p = sqlite3_get_auxdata(ctx, n);
+  if (ext_stats_corrente) {
+    if (p) EXT_STATS_SOMA(ext_stats_corrente->acertos, 1);
+    else EXT_STATS_SOMA(ext_stats_corrente->faltas, 1);
+  }
+  return p;
+}
+
+#define EXT_STATS_ALOCA(n) if (ext_stats_corrente) EXT_STATS_SOMA(ext_stats_corrente->bytes, (n))
+
+EXT_STATS_API void *ext_stats_malloc(int n)
+{
+  EXT_STATS_ALOCA(n);
+  return sqlite3_malloc(n);
+}
+
+EXT_STATS_API void *ext_stats_malloc64(sqlite3_uint64 n)
+{
+  EXT_STATS_ALOCA(n);
+  return sqlite3_malloc64(n);
+}
+
+EXT_STATS_API void *ext_stats_realloc(void *p, int n)
+{
+  EXT_STATS_ALOCA(n);
+  return sqlite3_realloc(p, n);
+}
+
+EXT_STATS_API void *ext_stats_realloc64(void *p, sqlite3_uint64 n)
+{
+  EXT_STATS_ALOCA(n);
+  return sqlite3_realloc64(p, n);
+}
+
+/*
+ * EXT_STATS_FONTE_<extensao>(coletor, zera) copia as estatísticas das funções
+ * da extensão no coletor informado via sqlite3_bind_pointer, se informado, e
+ * opcionalmente as zera.
+*/
+static void ext_stats_fonte(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  ext_stats_coletor *c = (ext_stats_coletor *) sqlite3_value_pointer(argv[0], "ext_stats_coletor");
+  sqlite3_mutex *mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_APP1);
+  int zera = sqlite3_value_int(argv[1]);
+  ext_stats_fn *fn;
+
+  sqlite3_mutex_enter(mutex);
+  for (fn = ext_stats_lista; fn; fn = fn->prox) {
+    if (c) {
+      if (c->n == c->capacidade) {
+        int k = c->capacidade ? 2 * c->capacidade : 64;
+        ext_stats_linha *l = (ext_stats_linha *) sqlite3_realloc(c->linhas, k * sizeof(ext_stats_linha));
+        if (!l) {
+          sqlite3_mutex_leave(mutex);
+          sqlite3_result_error_nomem(ctx);
+          return ;
+        }
+        c->linhas = l;
+        c->capacidade = k;
+      }
+      c->linhas[c->n].extensao = EXT_STATS_FONTE;
+      c->linhas[c->n++].fn = *fn;
+    }
+    if (zera) {
+      fn->chamadas = fn->total_ns = fn->max_ns = 0;
+      fn->bytes = fn->acertos = fn->faltas = 0;
+    }
+  }
+  sqlite3_mutex_leave(mutex);
+}
+
+/*
+ * Executa a função de leitura de cada extensão instrumentada carregada na
+ * conexão, ignorando as extensões não carregadas ou sem instrumentação.
+*/
+static int ext_stats_coleta(sqlite3 *db, ext_stats_coletor *c, int zera)
+{
+  sqlite3_stmt *stmt;
+  char *sql;
+  int j, r;
+
+  for (j = 0; j < (int) (sizeof(EXT_STATS_FONTES) / sizeof(EXT_STATS_FONTES[0])); ++j) {
+    sql = sqlite3_mprintf("SELECT EXT_STATS_FONTE_%s(?1, ?2)", EXT_STATS_FONTES[j]);
+    if (!sql) return SQLITE_NOMEM;
+    r = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    sqlite3_free(sql);
+    if (r != SQLITE_OK) continue;
+    if (c) sqlite3_bind_pointer(stmt, 1, c, "ext_stats_coletor", NULL);
+    sqlite3_bind_int(stmt, 2, zera);
+    sqlite3_step(stmt);
+    r = sqlite3_finalize(stmt);
+    if (r != SQLITE_OK) return r;
+  }
+  return SQLITE_OK;
+}
+
+/* EXT_STATS_RESET() zera as estatísticas de todas as extensões. */
+static void ext_stats_reset(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  int r = ext_stats_coleta(sqlite3_context_db_handle(ctx), NULL, 1);
+  if (r != SQLITE_OK) sqlite3_result_error_code(ctx, r);
+}
+
+/* Registra em stderr as declarações cujo tempo de execução excede o limite. */
+static int ext_stats_trace(unsigned tipo, void *limite, void *p, void *x)
+{
+  sqlite3_int64 ns = *(sqlite3_int64 *) x;
+  char *sql;
+
+  if (tipo == SQLITE_TRACE_PROFILE && ns >= (sqlite3_int64) (intptr_t) limite) {
+    sql = sqlite3_expanded_sql((sqlite3_stmt *) p);
+    fprintf(stderr, "declaração lenta: %.3f ms: %s\n", ns / 1e6,
+      sql ? sql : sqlite3_sql((sqlite3_stmt *) p));
+    sqlite3_free(sql);
+  }
+  return 0;
+}
+
+static void ext_stats_lentas_db(sqlite3 *db, sqlite3_int64 ms)
+{
+  if (ms > 0) {
+    sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, ext_stats_trace, (void *) (intptr_t) (ms * 1000000));
+  } else {
+    sqlite3_trace_v2(db, 0, NULL, NULL);
+  }
+}
+
+/* EXT_STATS_LENTAS(ms) define o limite do registro das declarações lentas. */
+static void ext_stats_lentas(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+  ext_stats_lentas_db(sqlite3_context_db_handle(ctx), sqlite3_value_int64(argv[0]));
+}
+
+/*
+ * Tabela virtual "eponymous" EXT_STATS com as estatísticas de todas as
+ * extensões instrumentadas, coletadas em xFilter.
+*/
+typedef struct ext_stats_cursor_s
+{
+  sqlite3_vtab_cursor base;
+  ext_stats_coletor coletor;
+  int i;
+}
+ext_stats_cursor;
+
+enum { EXT_STATS_EXTENSAO, EXT_STATS_FUNCAO, EXT_STATS_NARGS, EXT_STATS_CHAMADAS,
+       EXT_STATS_TOTAL_MS, EXT_STATS_MAX_MS, EXT_STATS_BYTES, EXT_STATS_ACERTOS,
+       EXT_STATS_FALTAS };
+
+typedef struct ext_stats_vtab_s
+{
+  sqlite3_vtab base;
+  sqlite3 *db;
+}
+ext_stats_vtab;
+
+static int ext_stats_connect(sqlite3 *db, void *aux, int argc, const char *const*argv,
+  sqlite3_vtab **ppVtab, char **err)
+{
+  ext_stats_vtab *v;
+  int r = sqlite3_declare_vtab(db, "CREATE TABLE x(extensao TEXT, funcao TEXT," \
+    " nargs INTEGER, chamadas INTEGER, total_ms REAL, max_ms REAL, bytes INTEGER," \
+    " acertos INTEGER, faltas INTEGER)");
+  if (r != SQLITE_OK) return r;
+  v = (ext_stats_vtab *) sqlite3_malloc(sizeof(ext_stats_vtab));
+  if (!v) return SQLITE_NOMEM;
+  memset(v, 0, sizeof(ext_stats_vtab));
+  v->db = db;
+  *ppVtab = &v->base;
+  return SQLITE_OK;
+}
+
+static int ext_stats_disconnect(sqlite3_vtab *vtab)
+{
+  sqlite3_free(vtab);
+  return SQLITE_OK;
+}
+
+static int ext_stats_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+  info->estimatedCost = 100;
+  return SQLITE_OK;
+}
+
+static int ext_stats_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+  ext_stats_cursor *c = (ext_stats_cursor *) sqlite3_malloc(sizeof(ext_stats_cursor));
+  if (!c) return SQLITE_NOMEM;
+  memset(c, 0, sizeof(ext_stats_cursor));
+  *ppCursor = &c->base;
+  return SQLITE_OK;
+}
+
+static int ext_stats_close(sqlite3_vtab_cursor *cur)
+{
+  sqlite3_free(((ext_stats_cursor *) cur)->coletor.linhas);
+  sqlite3_free(cur);
+  return SQLITE_OK;
+}
+
+static int ext_stats_filter(sqlite3_vtab_cursor *cur, int idxNum, const char *idxStr,
+  int argc, sqlite3_value **argv)
+{
+  ext_stats_cursor *c = (ext_stats_cursor *) cur;
+  c->coletor.n = 0;
+  c->i = 0;
+  return ext_stats_coleta(((ext_stats_vtab *) cur->pVtab)->db, &c->coletor, 0);
+}
+
+static int ext_stats_next(sqlite3_vtab_cursor *cur)
+{
+  ((ext_stats_cursor *) cur)->i++;
+  return SQLITE_OK;
+}
+
+static int ext_stats_eof(sqlite3_vtab_cursor *cur)
+{
+  ext_stats_cursor *c = (ext_stats_cursor *) cur;
+  return c->i >= c->coletor.n;
+}
+
+static int ext_stats_column(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int k)
+{
+  ext_stats_cursor *c = (ext_stats_cursor *) cur;
+  ext_stats_linha *l = c->coletor.linhas + c->i;
+
+  switch (k) {
+    case EXT_STATS_EXTENSAO:
+      sqlite3_result_text(ctx, l->extensao, -1, SQLITE_TRANSIENT);
+      break;
+    case EXT_STATS_FUNCAO:
+      sqlite3_result_text(ctx, l->fn.nome, -1, SQLITE_TRANSIENT);
+      break;
+    case EXT_STATS_NARGS:
+      sqlite3_result_int(ctx, l->fn.nargs);
+      break;
+    case EXT_STATS_CHAMADAS:
+      sqlite3_result_int64(ctx, l->fn.chamadas);
+      break;
+    case EXT_STATS_TOTAL_MS:
+      sqlite3_result_double(ctx, l->fn.total_ns / 1e6);
+      break;
+    case EXT_STATS_MAX_MS:
+      sqlite3_result_double(ctx, l->fn.max_ns / 1e6);
+      break;
+    case EXT_STATS_BYTES:
+      sqlite3_result_int64(ctx, l->fn.bytes);
+      break;
+    case EXT_STATS_ACERTOS:
+      sqlite3_result_int64(ctx, l->fn.acertos);
+      break;
+    case EXT_STATS_FALTAS:
+      sqlite3_result_int64(ctx, l->fn.faltas);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int ext_stats_rowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid)
+{
+  *pRowid = ((ext_stats_cursor *) cur)->i + 1;
+  return SQLITE_OK;
+}
+
+static sqlite3_module ext_stats_module = {
+  0,                  /* iVersion */
+  0,                  /* xCreate: somente eponymous */
+  ext_stats_connect,
+  ext_stats_best_index,
+  ext_stats_disconnect,
+  0,                  /* xDestroy */
+  ext_stats_open,
+  ext_stats_close,
+  ext_stats_filter,
+  ext_stats_next,
+  ext_stats_eof,
+  ext_stats_column,
+  ext_stats_rowid,
+};
+
+/*
+ * Registra a função de leitura da extensão e a interface comum, que é
+ * substituída pela registrada por cada extensão instrumentada carregada.
+*/
+static void ext_stats_registra(sqlite3 *db)
+{
+  const char *z = getenv("EXT_STATS_LENTAS");
+
+  sqlite3_create_function(db, EXT_STATS_NOME_FONTE, 2, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+    NULL, ext_stats_fonte, NULL, NULL);
+  sqlite3_create_function(db, "EXT_STATS_RESET", 0, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+    NULL, ext_stats_reset, NULL, NULL);
+  sqlite3_create_function(db, "EXT_STATS_LENTAS", 1, SQLITE_UTF8 | SQLITE_DIRECTONLY,
+    NULL, ext_stats_lentas, NULL, NULL);
+  sqlite3_create_module(db, "EXT_STATS", &ext_stats_module, NULL);
+  if (z && *z) ext_stats_lentas_db(db, atoll(z));
+}
+
+#define EXT_STATS_REGISTRA(db) ext_stats_registra(db)
+
+/* interposição das funções da API usadas pelo código das extensões */
+#undef sqlite3_create_function
+#define sqlite3_create_function ext_stats_create_function
+#undef sqlite3_create_function_v2
+#define sqlite3_create_function_v2 ext_stats_create_function_v2
+#undef sqlite3_user_data
+#define sqlite3_user_data ext_stats_user_data
+#undef sqlite3_get_auxdata
+#define sqlite3_get_auxdata ext_stats_get_auxdata
+#undef sqlite3_malloc
+#define sqlite3_malloc ext_stats_malloc
+#undef sqlite3_malloc64
+#define sqlite3_malloc64 ext_stats_malloc64
+#undef sqlite3_realloc
+#define sqlite3_realloc ext_stats_realloc
+#undef sqlite3_realloc64
+#define sqlite3_realloc64 ext_stats_realloc64
+
+#else
+
+#define EXT_STATS_REGISTRA(db)
+
+#endif /* EXT_STATS */
+
+#endif /* EXT_STATS_H */
@@ -0,0 +1,85 @@
+/*
+ * Biblioteca única com todas as extensões do projeto, "more-functions",
+ * "calendar", "concursos", "crypt" e "regexp", compiladas numa só unidade de
+ * ligação com otimização entre arquivos (-O3 -flto), cujo ponto de entrada
+ * registra as funções de todas as extensões ligadas:
+ *
+ *    make unificada            ou    make unificada-nativa (-march=native)
+ *
+ *    .load "path_to_lib/megasena.so"
+ *
+ * Modo "serving" da extensão "concursos" (ver sql/serving.sql):
+ *
+ *    .load "path_to_lib/megasena.so" "sqlite3_megasena_serving_init"
+ *
+ * As extensões ausentes na ligação, e.g.; "regexp" sem a glib, são ignoradas.
+ *
+ * Ligação estática num shell "sqlite3" próprio, compilado a partir do código
+ * fonte "amalgamation" do SQLite com as extensões em SQLITE_CORE, i.e.; com
+ * chamadas diretas à API, onde a inicialização do SQLite registra o ponto de
+ * entrada via sqlite3_auto_extension para todas as conexões, dispensando a
+ * carga de bibliotecas:
+ *
+ *    make shell SQLITE_SRC=path_to_sqlite_amalgamation
+*/
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+typedef int (*ponto_de_entrada)(sqlite3 *, char **, const sqlite3_api_routines *);
+
+/* referências fracas aos pontos de entrada das extensões ligadas */
+#define EXTENSAO(nome) \
+  int nome(sqlite3 *, char **, const sqlite3_api_routines *) __attribute__((weak))
+
+EXTENSAO(sqlite3_morefunctions_init);
+EXTENSAO(sqlite3_calendar_init);
+EXTENSAO(sqlite3_concursos_init);
+EXTENSAO(sqlite3_serving_init);
+EXTENSAO(sqlite3_crypt_init);
+EXTENSAO(sqlite3_regexp_init);
+
+/*
+ * Registra as extensões ligadas na ordem de "sqlite/onload", usando o ponto de
+ * entrada informado para a extensão "concursos".
+*/
+static int registra_extensoes(sqlite3 *db, char **err, const sqlite3_api_routines *api,
+  ponto_de_entrada concursos)
+{
+  ponto_de_entrada extensoes[] = {
+    sqlite3_morefunctions_init, concursos, sqlite3_calendar_init,
+    sqlite3_crypt_init, sqlite3_regexp_init
+  };
+  int j, r;
+
+  for (j = 0; j < sizeof(extensoes) / sizeof(extensoes[0]); ++j) {
+    if (!extensoes[j]) continue;
+    r = extensoes[j](db, err, api);
+    if (r != SQLITE_OK) return r;
+  }
+  return SQLITE_OK;
+}
+
+int sqlite3_megasena_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  SQLITE_EXTENSION_INIT2(api)
+
+  return registra_extensoes(db, err, api, sqlite3_concursos_init);
+}
+
+int sqlite3_megasena_serving_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+{
+  SQLITE_EXTENSION_INIT2(api)
+
+  return registra_extensoes(db, err, api, sqlite3_serving_init);
+}
+
+#ifdef SQLITE_CORE
+/*
+ * Registro automático para o shell ligado estaticamente, chamado ao fim de
+ * sqlite3_initialize() via -DSQLITE_EXTRA_INIT=sqlite3_megasena_auto.
+*/
+int sqlite3_megasena_auto(const char *nada)
+{
+  return sqlite3_auto_extension((void (*)(void)) sqlite3_megasena_init);
+}
+#endif
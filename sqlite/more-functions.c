@@ -20,7 +20,11 @@
 
 #ifdef COMPILE_SQLITE_EXTENSIONS_AS_LOADABLE_MODULE
 #include "sqlite3ext.h"
+#ifdef EXTENSAO_UNIFICADA
+SQLITE_EXTENSION_INIT3
+#else
 SQLITE_EXTENSION_INIT1
+#endif
 #else
 #include "sqlite3.h"
 #endif
@@ -92,6 +96,9 @@ static void group_productFinalize(sqlite3_context *context)
 
 #include <limits.h>
 
+#define EXT_STATS_FONTE "more_functions"
+#include "ext_stats.h"
+
 #define I64_NBITS (sizeof(i64) * CHAR_BIT)
 
 static char *int2bin(i64 n, char *buf)
@@ -737,9 +744,10 @@ int RegisterExtensionFunctions(sqlite3 *db)
 }
 
 #ifdef COMPILE_SQLITE_EXTENSIONS_AS_LOADABLE_MODULE
-int sqlite3_extension_init(sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi)
+int sqlite3_morefunctions_init(sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi)
 {
   SQLITE_EXTENSION_INIT2(pApi);
+  EXT_STATS_REGISTRA(db);
   RegisterExtensionFunctions(db);
   (void) setlocale(LC_ALL, "");
   return 0;
@@ -15,10 +15,15 @@
  * pela função a varias strings, pois mantém em cache cada instância compilada
  * do analisador de expressões.
  *
- * Funções de tratamento de strings UTF-8 via glibc:
+ * Funções de tratamento de strings UTF-8, com conversão direta dos caractéres
+ * ASCII e do suplemento Latin-1, senão via glib:
  *
  *    UTF8_UPPER, UTF8_LOWER
  *
+ * Collation indiferente à caixa das letras:
+ *
+ *    PT_BR_CI
+ *
  * Dependências:
  *
  *    "libsqlite3-dev" essencial para desenvolvimento de extensões SQLite
@@ -48,12 +53,20 @@
 */
 
 #include <sqlite3ext.h>
+#ifdef EXTENSAO_UNIFICADA
+SQLITE_EXTENSION_INIT3
+#else
 SQLITE_EXTENSION_INIT1
+#endif
 
 #include <stdlib.h>
 #include <string.h>
+#include <locale.h>
 #include <glib.h>
 
+#define EXT_STATS_FONTE "regexp"
+#include "ext_stats.h"
+
 #ifdef PCRE
 
 #include <pcre.h>
@@ -656,6 +669,138 @@ static void regexp_version(sqlite3_context *ctx, int argc, sqlite3_value **argv)
   sqlite3_free(z);
 }
 
+/*
+ * Conversão de caixa das letras do suplemento Latin-1 (U+00C0..U+00FF), cuja
+ * codificação UTF-8 é 0xC3 seguido de 0x80..0xBF, indexada pelo segundo byte
+ * e preservando o comprimento, tal que 0 indica que a conversão não preserva
+ * o comprimento (ß -> SS, ÿ -> Ÿ) e deve ser efetuada pela glib.
+*/
+static const unsigned char LATIN1_UPPER[64] = {
+  0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+  0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F,
+  0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+  0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x00,
+  0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+  0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F,
+  0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0xB7,
+  0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x00
+};
+
+static const unsigned char LATIN1_LOWER[64] = {
+  0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+  0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF,
+  0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0x97,
+  0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0x9F,
+  0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+  0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF,
+  0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7,
+  0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF
+};
+
+typedef unsigned long long u64;
+
+#define SWAR_ALTO 0x8080808080808080ULL
+#define SWAR_UNS  0x0101010101010101ULL
+
+/*
+ * Converte simultaneamente a caixa das letras em 8 bytes ASCII, cujo intervalo
+ * de letras a converter é [primeira, ultima], invertendo o bit 0x20 somente
+ * nos bytes do intervalo.
+*/
+static u64 swar_caixa(u64 x, int primeira, int ultima)
+{
+  u64 ge = x + SWAR_UNS * (0x80 - primeira);
+  u64 gt = x + SWAR_UNS * (0x80 - ultima - 1);
+  return x ^ (((ge & ~gt) & SWAR_ALTO) >> 2);
+}
+
+/*
+ * Testa se o locale dos caractéres tem regras especiais de conversão de caixa
+ * na glib (turco, azeri e lituano), que não são contempladas na conversão
+ * direta.
+*/
+static int locale_especial(void)
+{
+  const char *z = setlocale(LC_CTYPE, NULL);
+  return z && (strncmp(z, "tr", 2) == 0 || strncmp(z, "az", 2) == 0
+    || strncmp(z, "lt", 2) == 0);
+}
+
+/*
+ * Converte a caixa da string de "n" bytes para o buffer "rz" de comprimento
+ * igual, usando 8 bytes por vez nos trechos ASCII e as tabelas do suplemento
+ * Latin-1, retornando zero se a string contém caractéres cuja conversão é
+ * delegada à glib.
+*/
+static int converte_caixa(const unsigned char *z, int n, unsigned char *rz, int alta)
+{
+  const unsigned char *tabela = alta ? LATIN1_UPPER : LATIN1_LOWER;
+  int primeira = alta ? 'a' : 'A', ultima = alta ? 'z' : 'Z';
+  int j = 0;
+  u64 x;
+
+  while (j < n) {
+    if (j + 8 <= n) {
+      memcpy(&x, z+j, 8);
+      if (!(x & SWAR_ALTO)) {
+        x = swar_caixa(x, primeira, ultima);
+        memcpy(rz+j, &x, 8);
+        j += 8;
+        continue;
+      }
+    }
+    if (z[j] < 0x80) {
+      rz[j] = (z[j] >= primeira && z[j] <= ultima) ? z[j] ^ 0x20 : z[j];
+      ++j;
+    } else if (j + 1 < n && (z[j+1] & 0xC0) == 0x80
+               && (z[j] == 0xC3 || (z[j] == 0xC2 && !(alta && z[j+1] == 0xB5)))) {
+      // µ (U+00B5) tem maiúscula grega, portanto é delegada à glib
+      rz[j] = z[j];
+      rz[j+1] = (z[j] == 0xC3) ? tabela[z[j+1] - 0x80] : z[j+1];
+      if (!rz[j+1]) return 0;
+      j += 2;
+    } else {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Conversão de caixa comum a UTF8_UPPER e UTF8_LOWER, diretamente na memória
+ * do resultado alocada via SQLite, senão via glib.
+*/
+static void utf8_caixa(sqlite3_context *ctx, sqlite3_value *arg, int alta)
+{
+  const unsigned char *z = sqlite3_value_text(arg);
+  unsigned char *rz;
+  int n;
+
+  if (!z) {
+    sqlite3_result_null(ctx);
+    return ;
+  }
+  n = sqlite3_value_bytes(arg);
+
+  if (!locale_especial()) {
+    rz = sqlite3_malloc(n + 1);
+    if (!rz) {
+      sqlite3_result_error_nomem(ctx);
+      return ;
+    }
+    if (converte_caixa(z, n, rz, alta)) {
+      rz[n] = 0;
+      sqlite3_result_text(ctx, (char *) rz, n, sqlite3_free);
+      return ;
+    }
+    sqlite3_free(rz);
+  }
+
+  rz = (unsigned char *) (alta ? g_utf8_strup((const gchar *) z, n)
+    : g_utf8_strdown((const gchar *) z, n));
+  sqlite3_result_text(ctx, (char *) rz, -1, g_free);
+}
+
 /**
  * Converte caractéres minúsculos de string em maiúsculos, inclusive caractéres
  * Unicode quando possível, usando o "locale" do sistema.
@@ -666,14 +811,7 @@ static void regexp_version(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 */
 static void utf8_upper(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *rz;
-  char *str = (char *) sqlite3_value_text(argv[0]);
-  if (!str) {
-    sqlite3_result_null(ctx);
-  } else {
-    rz = (char *) g_utf8_strup(str, -1);
-    sqlite3_result_text(ctx, rz, -1, SQLITE_TRANSIENT);
-  }
+  utf8_caixa(ctx, argv[0], 1);
 }
 
 /**
@@ -686,19 +824,66 @@ static void utf8_upper(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 */
 static void utf8_lower(sqlite3_context *ctx, int argc, sqlite3_value **argv)
 {
-  char *rz;
-  char *str = (char *) sqlite3_value_text(argv[0]);
-  if (!str) {
-    sqlite3_result_null(ctx);
-  } else {
-    rz = (char *) g_utf8_strdown(str, -1);
-    sqlite3_result_text(ctx, rz, -1, SQLITE_TRANSIENT);
+  utf8_caixa(ctx, argv[0], 0);
+}
+
+/*
+ * Retorna o próximo caractére da string de "n" bytes a partir da posição "*k"
+ * convertido em minúsculo, avançando a posição. Bytes que não iniciam
+ * caractéres UTF-8 válidos são retornados como tal.
+*/
+static gunichar proximo_ci(const unsigned char *z, int n, int *k)
+{
+  gunichar c;
+  int j = *k;
+
+  if (z[j] < 0x80) {
+    *k = j + 1;
+    return (z[j] >= 'A' && z[j] <= 'Z') ? z[j] ^ 0x20 : z[j];
+  }
+  if (z[j] == 0xC3 && j + 1 < n && (z[j+1] & 0xC0) == 0x80) {
+    *k = j + 2;
+    return 0xC0 + (LATIN1_LOWER[z[j+1] - 0x80] - 0x80);
+  }
+  c = g_utf8_get_char_validated((const gchar *) z + j, n - j);
+  if (c == (gunichar) -1 || c == (gunichar) -2) {
+    *k = j + 1;
+    return z[j];
+  }
+  *k = j + (c < 0x800 ? 2 : c < 0x10000 ? 3 : 4);
+  return g_unichar_tolower(c);
+}
+
+/**
+ * Collation "pt_BR_ci" que compara strings UTF-8 indiferentemente à caixa das
+ * letras, inclusive acentuadas, sem alocação de memória, e.g.:
+ *
+ *    SELECT cidade, COUNT(*) FROM ganhadores GROUP BY cidade COLLATE pt_BR_ci;
+ *
+ *    CREATE INDEX ganhadores_cidade ON ganhadores (cidade COLLATE pt_BR_ci);
+ *
+ * @return Valor negativo, zero ou positivo conforme a primeira string precede,
+ *         equivale ou sucede a segunda.
+*/
+static int pt_br_ci(void *arg, int n1, const void *z1, int n2, const void *z2)
+{
+  const unsigned char *a = (const unsigned char *) z1;
+  const unsigned char *b = (const unsigned char *) z2;
+  gunichar c1, c2;
+  int j = 0, k = 0;
+
+  while (j < n1 && k < n2) {
+    c1 = proximo_ci(a, n1, &j);
+    c2 = proximo_ci(b, n2, &k);
+    if (c1 != c2) return c1 < c2 ? -1 : 1;
   }
+  return (j < n1) - (k < n2);
 }
 
-int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
+int sqlite3_regexp_init(sqlite3 *db, char **err, const sqlite3_api_routines *api)
 {
   SQLITE_EXTENSION_INIT2(api)
+  EXT_STATS_REGISTRA(db);
 
   sqlite3_create_function(db, "REGEXP_VERSION", 0, SQLITE_UTF8, NULL, regexp_version, NULL, NULL);
   sqlite3_create_function(db, "REGEXP", 2, SQLITE_UTF8, NULL, regexp, NULL, NULL);
@@ -710,6 +895,7 @@ int sqlite3_extension_init(sqlite3 *db, char **err, const sqlite3_api_routines *
   sqlite3_create_function(db, "REGEXP_MATCH_POSITION", 3, SQLITE_UTF8, NULL, regexp_match_position, NULL, NULL);
   sqlite3_create_function(db, "UTF8_UPPER", 1, SQLITE_UTF8, NULL, utf8_upper, NULL, NULL);
   sqlite3_create_function(db, "UTF8_LOWER", 1, SQLITE_UTF8, NULL, utf8_lower, NULL, NULL);
+  sqlite3_create_collation(db, "PT_BR_CI", SQLITE_UTF8, NULL, pt_br_ci);
 
   return 0;
 }
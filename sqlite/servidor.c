@@ -0,0 +1,315 @@
+/*
+ * Servidor local de consultas ao db da Mega-Sena via "Unix domain socket",
+ * que mantém uma única conexão com as extensões carregadas e seus caches
+ * aquecidos, servindo as consultas nomeadas e parametrizadas do arquivo
+ * "sql/consultas.sql", preparadas uma única vez na inicialização.
+ *
+ * Cada consulta no arquivo é precedida pela linha de comentário que a nomeia:
+ *
+ *    -- consulta: ultima_aparicao
+ *    SELECT ... WHERE ... bitstatus(dezenas, ?1-1)
+ *
+ * Protocolo de cada conexão: o cliente envia uma linha com o nome da consulta
+ * seguido dos argumentos separados por TAB e o servidor responde com o byte
+ * '+' seguido dos registros, cujos campos são separados por US (0x1F) e os
+ * registros terminados por LF, ou com o byte '-' seguido da mensagem de erro,
+ * encerrando a conexão. Os registros são acumulados antes do envio, tal que
+ * falhas na execução não resultam em respostas parciais. Argumentos numéricos
+ * são vinculados como números, os demais como texto.
+ *
+ * Compilação:
+ *
+ *    gcc servidor.c -Wall -O2 -lsqlite3 -o servidor
+ *
+ * Uso a partir do diretório do projeto, tal qual os scripts, com o cliente
+ * "sqlite/cliente":
+ *
+ *    ./sqlite/servidor [-s socket] [-q consultas.sql] megasena.sqlite &
+ *
+ *    ./sqlite/cliente ultima_aparicao 13
+*/
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define SOCKET_PADRAO "/tmp/megasena.sock"
+#define CONSULTAS_PADRAO "sql/consultas.sql"
+#define MARCA_CONSULTA "-- consulta:"
+#define MAX_REQUISICAO 65536
+#define MAX_ARGUMENTOS 32
+#define TIMEOUT_CONEXAO 5   /* segundos de espera por leitura ou escrita */
+
+#define US '\x1F'   /* separador de campos das respostas */
+
+/* extensões carregadas na conexão, conforme "sqlite/serving" */
+static const char *EXTENSOES[][2] = {
+  { "./sqlite/more-functions.so", NULL },
+  { "./sqlite/concursos.so", "sqlite3_serving_init" },
+  { "./sqlite/calendar.so", NULL },
+};
+
+typedef struct consulta_s
+{
+  char *nome;
+  sqlite3_stmt *stmt;
+}
+consulta_t;
+
+static consulta_t *consultas;
+static int nconsultas;
+
+static volatile sig_atomic_t terminar;
+
+static void encerra(int sig)
+{
+  terminar = 1;
+}
+
+static void falha(const char *msg, const char *detalhe)
+{
+  fprintf(stderr, "servidor: %s%s%s\n", msg, detalhe ? ": " : "", detalhe ? detalhe : "");
+  exit(1);
+}
+
+/*
+ * Lê o arquivo das consultas nomeadas e prepara cada consulta como persistente.
+*/
+static void prepara_consultas(sqlite3 *db, const char *arquivo)
+{
+  FILE *f = fopen(arquivo, "r");
+  char *texto, *p, *fim, *sql;
+  long n;
+
+  if (!f) falha("arquivo de consultas não está disponível", arquivo);
+  fseek(f, 0, SEEK_END);
+  n = ftell(f);
+  rewind(f);
+  texto = (char *) malloc(n + 1);
+  if (!texto || fread(texto, 1, n, f) != (size_t) n) falha("falha na leitura", arquivo);
+  texto[n] = 0;
+  fclose(f);
+
+  for (p = strstr(texto, MARCA_CONSULTA); p; p = fim) {
+    char *nome = p + strlen(MARCA_CONSULTA);
+    consulta_t *c;
+    nome += strspn(nome, " \t");
+    sql = nome + strcspn(nome, " \t\r\n");
+    fim = strstr(sql, MARCA_CONSULTA);
+    if (fim) *fim = 0;
+    if (*sql) *sql++ = 0;
+
+    consultas = (consulta_t *) realloc(consultas, (nconsultas + 1) * sizeof(consulta_t));
+    if (!consultas) falha("memória insuficiente", NULL);
+    c = consultas + nconsultas++;
+    c->nome = strdup(nome);
+    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &c->stmt, NULL) != SQLITE_OK
+        || !c->stmt) {
+      fprintf(stderr, "servidor: consulta \"%s\" inválida: %s\n", nome, sqlite3_errmsg(db));
+      exit(1);
+    }
+  }
+  free(texto);
+}
+
+static consulta_t *pesquisa_consulta(const char *nome)
+{
+  int j;
+  for (j = 0; j < nconsultas; ++j) {
+    if (strcmp(consultas[j].nome, nome) == 0) return consultas + j;
+  }
+  return NULL;
+}
+
+/* Vincula o argumento como inteiro, real ou texto conforme seu conteúdo. */
+static int vincula(sqlite3_stmt *stmt, int k, const char *z)
+{
+  char *fim;
+  long long i;
+  double x;
+
+  if (*z) {
+    errno = 0;
+    i = strtoll(z, &fim, 10);
+    if (!*fim && !errno) return sqlite3_bind_int64(stmt, k, i);
+    x = strtod(z, &fim);
+    if (!*fim) return sqlite3_bind_double(stmt, k, x);
+  }
+  return sqlite3_bind_text(stmt, k, z, -1, SQLITE_TRANSIENT);
+}
+
+/*
+ * Executa a consulta requisitada, escrevendo a resposta conforme o protocolo.
+*/
+static void executa(sqlite3 *db, char *requisicao, FILE *out)
+{
+  char *argv[MAX_ARGUMENTOS+1];
+  sqlite3_str *resposta;
+  consulta_t *c;
+  int argc = 0, j, n, r;
+
+  requisicao[strcspn(requisicao, "\r\n")] = 0;
+  argv[argc++] = requisicao;
+  for (j = 0; requisicao[j]; ++j) {
+    if (requisicao[j] == '\t') {
+      requisicao[j] = 0;
+      if (argc > MAX_ARGUMENTOS) {
+        fputs("-excesso de argumentos\n", out);
+        return ;
+      }
+      argv[argc++] = requisicao + j + 1;
+    }
+  }
+  if (!(c = pesquisa_consulta(argv[0]))) {
+    fprintf(out, "-consulta \"%s\" é desconhecida\n", argv[0]);
+    return ;
+  }
+  if (argc - 1 != sqlite3_bind_parameter_count(c->stmt)) {
+    fprintf(out, "-consulta \"%s\" requer %d argumento(s)\n", c->nome,
+      sqlite3_bind_parameter_count(c->stmt));
+    return ;
+  }
+  for (j = 1; j < argc; ++j) vincula(c->stmt, j, argv[j]);
+
+  /* registros acumulados na resposta que é descartada se a execução falha */
+  resposta = sqlite3_str_new(db);
+  n = sqlite3_column_count(c->stmt);
+  while ((r = sqlite3_step(c->stmt)) == SQLITE_ROW) {
+    for (j = 0; j < n; ++j) {
+      const char *z = (const char *) sqlite3_column_text(c->stmt, j);
+      if (j) sqlite3_str_appendchar(resposta, 1, US);
+      if (z) sqlite3_str_appendall(resposta, z);
+    }
+    sqlite3_str_appendchar(resposta, 1, '\n');
+  }
+  if (r != SQLITE_DONE) {
+    fprintf(out, "-%s\n", sqlite3_errmsg(db));
+  } else if (sqlite3_str_errcode(resposta) != SQLITE_OK) {
+    fputs("-memória insuficiente\n", out);
+  } else {
+    fputc('+', out);
+    fwrite(sqlite3_str_value(resposta), 1, sqlite3_str_length(resposta), out);
+  }
+  sqlite3_free(sqlite3_str_finish(resposta));
+  sqlite3_reset(c->stmt);
+  sqlite3_clear_bindings(c->stmt);
+}
+
+/*
+ * Lê a linha de requisição da conexão, retornando zero se o cliente não a
+ * envia no prazo TIMEOUT_CONEXAO, tal que clientes ociosos não bloqueiam os
+ * demais.
+*/
+static int le_requisicao(int fd, char *buf)
+{
+  struct timeval prazo = { TIMEOUT_CONEXAO, 0 };
+  int n = 0, k;
+
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &prazo, sizeof(prazo)) < 0
+      || setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &prazo, sizeof(prazo)) < 0) return 0;
+  while (n < MAX_REQUISICAO - 1) {
+    k = read(fd, buf + n, MAX_REQUISICAO - 1 - n);
+    if (k < 0 && errno == EINTR) continue;
+    if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    if (k <= 0) break;
+    n += k;
+    if (memchr(buf + n - k, '\n', k)) break;
+  }
+  buf[n] = 0;
+  return n;
+}
+
+/*
+ * Cria o socket no endereço informado, substituindo socket remanescente de
+ * servidor encerrado abruptamente, mas não de servidor em execução.
+*/
+static int cria_socket(const char *endereco)
+{
+  struct sockaddr_un sa;
+  int s = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if (s < 0) falha("falha na criação do socket", strerror(errno));
+  if (strlen(endereco) >= sizeof(sa.sun_path)) falha("endereço do socket é longo demais", endereco);
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  strcpy(sa.sun_path, endereco);
+
+  if (connect(s, (struct sockaddr *) &sa, sizeof(sa)) == 0) {
+    falha("servidor já está em execução", endereco);
+  }
+  unlink(endereco);
+  if (bind(s, (struct sockaddr *) &sa, sizeof(sa)) < 0 || listen(s, 16) < 0) {
+    falha("falha na vinculação do socket", strerror(errno));
+  }
+  return s;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *endereco = SOCKET_PADRAO, *arquivo = CONSULTAS_PADRAO;
+  static char requisicao[MAX_REQUISICAO];
+  struct sigaction sa;
+  sqlite3 *db;
+  char *err;
+  int opt, s, fd, j;
+
+  while ((opt = getopt(argc, argv, "s:q:")) != -1) {
+    switch (opt) {
+      case 's': endereco = optarg; break;
+      case 'q': arquivo = optarg; break;
+      default:
+        fprintf(stderr, "uso: %s [-s socket] [-q consultas.sql] db\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "uso: %s [-s socket] [-q consultas.sql] db\n", argv[0]);
+    return 1;
+  }
+
+  if (sqlite3_open_v2(argv[optind], &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK) {
+    falha("db não está disponível", sqlite3_errmsg(db));
+  }
+  sqlite3_enable_load_extension(db, 1);
+  for (j = 0; j < sizeof(EXTENSOES) / sizeof(EXTENSOES[0]); ++j) {
+    if (sqlite3_load_extension(db, EXTENSOES[j][0], EXTENSOES[j][1], &err) != SQLITE_OK) {
+      falha("falha na carga da extensão", err);
+    }
+  }
+  sqlite3_enable_load_extension(db, 0);
+  prepara_consultas(db, arquivo);
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = encerra;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  s = cria_socket(endereco);
+  while (!terminar) {
+    FILE *out;
+    if ((fd = accept(s, NULL, NULL)) < 0) continue;
+    if (le_requisicao(fd, requisicao) > 0 && (out = fdopen(fd, "w"))) {
+      executa(db, requisicao, out);
+      fclose(out);
+    } else {
+      close(fd);
+    }
+  }
+
+  close(s);
+  unlink(endereco);
+  for (j = 0; j < nconsultas; ++j) {
+    sqlite3_finalize(consultas[j].stmt);
+    free(consultas[j].nome);
+  }
+  free(consultas);
+  sqlite3_close(db);
+  return 0;
+}